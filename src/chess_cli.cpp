@@ -0,0 +1,230 @@
+/*
+ * chess_cli.cpp
+ *
+ * Copyright 2017 Valentino Esposito <valentinoe85@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ *
+ */
+
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "chessboard.hpp"
+
+//write the legal moves of the position in short algebraic notation
+int listlegal(std::string fen) {
+  ChessBoardBatch cb(fen);
+  if (! cb.isvalid()) {return 1;}
+  MoveList legal;
+  cb.generate_legal(legal);
+
+  char buf[notationsize];
+  for (packedmove m : legal) {
+    cb.writemove(m, buf);
+    std::cout << buf << " ";
+  }
+  std::cout << std::endl;
+  return 0;
+}
+
+/* do the moves from the given position, write them in short algebraic notation and the final position in FEN notation.
+ * If no moves are given they are read from the standard input, until its end. If recfile is given the game is written
+ * there while playing (it is removed at the end, it is left only if the program does not end properly).
+ * If savefile is given the game is saved there in native format at the end.
+ */
+int playmoves(std::string fen, std::vector<std::string> moves, std::string recfile, std::string savefile = "") {
+  ChessBoardBatch cb(fen);
+  if (! cb.isvalid()) {return 1;}
+  if (recfile.size() > 0 && ! cb.wrpsetrecovery(recfile)) {
+    std::cerr << "Error, the recovery file " << recfile << " cannot be created!" << std::endl;
+    return 1;
+  }
+
+  bool fromstdin = moves.empty();
+  std::string line;
+  unsigned int nmove = 0;
+  while (! moves.empty() || (fromstdin && std::getline(std::cin, line))) {
+    if (fromstdin) {
+      std::istringstream words(line);
+      std::string word;
+      while (words >> word) {moves.push_back(word);}
+    }
+    for (const std::string& mv : moves) {
+      nmove++;
+      if (! cb.wrpplaymove(mv)) {
+        std::cout << std::endl << "Illegal move " << mv << " (move " << nmove << ")" << std::endl;
+        return 1;
+      }
+    }
+    moves.clear();
+  }
+  std::cout << cb.wrpgethistory(false, false, false) << std::endl;
+  std::cout << cb.genFEN() << std::endl;
+  if (savefile.size() > 0 && ! cb.wrpsavegame(savefile)) {
+    std::cerr << "Error, the file " << savefile << " cannot be written!" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+//load a game saved in native format (or a recovery file), write its moves in short algebraic notation and the final position in FEN notation
+int loadsaved(std::string filename) {
+  ChessBoardBatch cb;
+  if (! cb.wrploadgame(filename)) {
+    std::cout << "invalid saved game " << filename << std::endl;
+    return 1;
+  }
+  std::cout << cb.wrpgethistory(false, false, false) << std::endl;
+  std::cout << cb.genFEN() << std::endl;
+  return 0;
+}
+
+//read FEN positions from the standard input, one for each line, and write them again in normalized form or "invalid"
+int checkfens() {
+  const std::size_t batchsize = 4096;
+  std::vector<std::string> lines(batchsize);
+  std::vector<std::string_view> views(batchsize);
+  std::vector<ChessBitboard> pos(batchsize);
+  std::vector<char> out(batchsize * fensize);
+  std::size_t ninvalid = 0;
+
+  bool more = true;
+  while (more) {
+    std::size_t n = 0;
+    while (n < batchsize && std::getline(std::cin, lines[n])) {views[n] = lines[n]; n++;}
+    more = (n == batchsize);
+
+    ninvalid += n - ChessBitboard::readfens(views.data(), n, pos.data());
+    ChessBitboard::writefens(pos.data(), n, out.data());
+    for (std::size_t i = 0; i < n; i++) {
+      if (pos[i].kingsquare(white) == -1) {std::cout << "invalid" << std::endl;} //the invalid positions are left empty
+      else {std::cout << out.data() + i * fensize << std::endl;}
+    }
+  }
+  return (ninvalid == 0) ? 0 : 1;
+}
+
+//replay all the games of a PGN file, writing the final position of each game
+int replaypgn(std::string filename) {
+  ChessPGN pgnf(filename, 'r');
+  int nbad = 0;
+
+  for (unsigned int g = 0; g < pgnf.numgames(); g++) {
+    ChessBoardBatch cb(pgnf.readfield(g, "FEN"));
+    std::cout << "Game " << g + 1 << ": ";
+    if (! cb.isvalid()) {
+      std::cout << "invalid FEN " << pgnf.readfield(g, "FEN") << std::endl;
+      nbad++;
+    } else if (cb.wrploadgame(pgnf.readmoves(g))) {std::cout << cb.genFEN() << std::endl;}
+    else {
+      std::cout << "illegal move after " << cb.wrpgethistory(false, false, true) << std::endl;
+      nbad++;
+    }
+  }
+  return (nbad == 0) ? 0 : 1;
+}
+
+//save a game in native format and load it back, checking the evaluations and the players. Return false if something is lost
+bool checksaved() {
+  std::string savename = (std::filesystem::temp_directory_path() / "yagchess-cli-check").string();
+  ChessBoardBatch saved, loaded;
+  const char* moves[3] = {"e4", "e5", "Nf3"};
+  const std::int16_t evals[3] = {35, -12, ChessUCI::matescore - 2};
+  saved.sethumplayers({{true, false}});
+  for (int i = 0; i < 3; i++) {
+    saved.wrpplaymove(moves[i]);
+    saved.wrpseteval(evals[i]);
+  }
+  bool res = saved.wrpsavegame(savename) && loaded.wrploadgame(savename);
+  res = res && loaded.genFEN() == saved.genFEN() && loaded.gethumplayers() == saved.gethumplayers();
+  for (int i = 0; i < 3; i++) {res = res && loaded.wrpgeteval(i + 1) == evals[i];}
+  std::remove(savename.c_str());
+  return res;
+}
+
+//the snapshot of a game started by black must keep the hash key of the player who moves, the one got by its FEN notation
+bool checksnapshot() {
+  ChessBoardBatch blstart("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+  ChessBitboard fromfen;
+  return blstart.wrpplaymove("e5") && fromfen.readfen(blstart.genFEN()) && fromfen.hashkey() == blstart.getposition().hashkey();
+}
+
+//run the checks of the library which are not move counts (these are done by yagchess-perft), return 0 if all of them pass
+int runchecks() {
+  const std::pair<const char*, bool (*)()> checks[] = {
+    {"Game saved in native format and loaded back", checksaved},
+    {"Hash key of the snapshot of a game started by black", checksnapshot}
+  };
+  int nfailed = 0;
+  for (const auto& ck : checks) {
+    bool ok = ck.second();
+    std::cout << ck.first << (ok ? ": ok" : ": FAILED") << std::endl;
+    if (! ok) {nfailed++;}
+  }
+  return (nfailed == 0) ? 0 : 1;
+}
+
+void printusage() {
+  std::cout << "Usage: yagchess-cli command [arguments]" << std::endl;
+  std::cout << "Chess rules without the GUI (gtkmm is not needed)." << std::endl;
+  std::cout << "  legal [FEN]                 write the legal moves of the position (the start position if not given)" << std::endl;
+  std::cout << "  moves [--fen FEN] [--recovery file] [move...]" << std::endl;
+  std::cout << "                              do the moves (SAN, LAN or UCI notation) and write the final position in FEN notation," << std::endl;
+  std::cout << "                              the moves are read from the standard input if not given. With --recovery the game is" << std::endl;
+  std::cout << "                              written in the file while playing, the file is left if the program is interrupted" << std::endl;
+  std::cout << "  save file [--fen FEN] [move...]" << std::endl;
+  std::cout << "                              do the moves as the moves command and save the game in native format" << std::endl;
+  std::cout << "  load file                   load a game saved in native format, or a recovery file, and write its moves and final position" << std::endl;
+  std::cout << "  fen                         read FEN positions from the standard input, one for each line, and write them normalized" << std::endl;
+  std::cout << "  pgn file                    replay the games of a PGN file and write the final position of each one" << std::endl;
+  std::cout << "  check                       run the checks of saving, loading and snapshots of the games" << std::endl;
+}
+
+//main function, select the command
+int main(int argc, char *argv[]) {
+  if (argc < 2) {printusage(); return 1;}
+  std::string comm = argv[1];
+
+  if (comm == "--help") {printusage(); return 0;}
+  else if (comm == "legal") {return listlegal((argc > 2) ? argv[2] : "");}
+  else if (comm == "fen") {return checkfens();}
+  else if (comm == "check") {return runchecks();}
+  else if (comm == "pgn" && argc > 2) {return replaypgn(argv[2]);}
+  else if (comm == "load" && argc > 2) {return loadsaved(argv[2]);}
+  else if (comm == "moves" || (comm == "save" && argc > 2)) {
+    std::string fen, recfile, savefile;
+    std::vector<std::string> moves;
+    int first = 2;
+    if (comm == "save") {savefile = argv[first++];}
+    for (int i = first; i < argc; i++) {
+      std::string cuarg = argv[i];
+      if (cuarg == "--fen" && i + 1 < argc) {fen = argv[++i];}
+      else if (cuarg == "--recovery" && i + 1 < argc) {recfile = argv[++i];}
+      else {moves.push_back(cuarg);}
+    }
+    return playmoves(fen, moves, recfile, savefile);
+  }
+
+  printusage();
+  return 1;
+}
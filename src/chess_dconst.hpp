@@ -31,6 +31,9 @@ enum wpiece {generic, pawn, rock, knight, bishop, queen, king, fakepawn};
 enum gamefinal {notfinished, tie, blackwins, whitewins};
 enum howplopt {huhu, huce, cehu, cece, alte};
 
+//non member overload operator for get opposite color
+inline c_color operator ! (const c_color cc) {return (cc == white) ? black : white;}
+
 //preprocessor constants
 #define MINX 0
 #define MAXX 8
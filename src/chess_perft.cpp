@@ -0,0 +1,162 @@
+/*
+ * chess_perft.cpp
+ * 
+ * Copyright 2017 Valentino Esposito <valentinoe85@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+
+#include "chessboard.hpp"
+
+/* A position of the test suite with the expected number of move sequences at each depth (starting from depth 1)
+ * See https://www.chessprogramming.org/Perft_Results
+ */
+struct PerftCase {
+  std::string name;
+  std::string fen;
+  std::vector<std::uint64_t> expected;
+};
+
+const std::vector<PerftCase> perftsuite = {
+  {"Start position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", {20, 400, 8902, 197281, 4865609}},
+  {"Kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", {48, 2039, 97862, 4085603}},
+  {"Position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", {14, 191, 2812, 43238, 674624}},
+  {"Position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", {6, 264, 9467, 422333}},
+  {"Position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", {44, 1486, 62379, 2103487}},
+  {"Position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", {46, 2079, 89890, 3894594}}
+};
+
+//FEN texts which must be rejected: the moves from such positions could not be generated
+const std::vector<std::string> invalidfens = {
+  "P6k/8/8/8/8/8/8/K7 w - - 0 1", //pawn in the last row
+  "k7/8/8/8/8/8/8/K6p b - - 0 1", //pawn in the first row
+  "8/8/8/8/8/8/8/K7 w - - 0 1", //no black king
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1", //no player who moves
+  "rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", //row too long
+  "7k/8/8/8/8/8/8/R3K2R w KQ - 0 1", //king of the player who does not move in check
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 garbage", //text after the turn
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm e4" //EPD operation without the semicolon
+};
+
+//time in seconds spent by the perft of a chessboard at the given depth, the number of sequences is written in nodes
+double timedperft(const ChessBoard& cb, int depth, std::uint64_t& nodes) {
+  auto start = std::chrono::steady_clock::now();
+  nodes = cb.perft(depth);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+//write a line of the report
+void printrate(int depth, std::uint64_t nodes, double secs) {
+  std::cout << "  depth " << std::setw(2) << depth << std::setw(12) << nodes << " nodes" << std::fixed << std::setprecision(3) << std::setw(10) << secs << " s";
+  if (secs > 0) {std::cout << std::setw(14) << static_cast<std::uint64_t>(nodes / secs) << " nodes/s";}
+}
+
+//run the whole suite, return true if all the counts are the expected ones
+bool runsuite() {
+  bool allok = true;
+  std::uint64_t totnodes = 0;
+  double totsecs = 0;
+
+  for (const PerftCase& pc : perftsuite) {
+    ChessBoardBatch cb(pc.fen);
+    std::cout << pc.name << ": " << pc.fen << std::endl;
+    for (unsigned int d = 0; d < pc.expected.size(); d++) {
+      std::uint64_t nodes;
+      double secs = timedperft(cb, d + 1, nodes);
+      totnodes += nodes;
+      totsecs += secs;
+      printrate(d + 1, nodes, secs);
+      if (nodes == pc.expected[d]) {std::cout << "  ok" << std::endl;}
+      else {
+        std::cout << "  FAILED, expected " << pc.expected[d] << std::endl;
+        allok = false;
+      }
+    }
+  }
+
+  for (const std::string& fen : invalidfens) {
+    ChessBitboard pos;
+    if (pos.readfen(fen)) {
+      std::cout << "Invalid FEN " << fen << " accepted, FAILED" << std::endl;
+      allok = false;
+    }
+  }
+
+  std::cout << "Total: " << totnodes << " nodes in " << std::fixed << std::setprecision(3) << totsecs << " s";
+  if (totsecs > 0) {std::cout << ", " << static_cast<std::uint64_t>(totnodes / totsecs) << " nodes/s";}
+  std::cout << std::endl;
+  return allok;
+}
+
+//count the sequences of a single position, optionally dividing the count among the first moves. Return false if the position is not valid
+bool runposition(std::string fen, int depth, bool divide) {
+  ChessBoardBatch cb(fen);
+  if (! cb.isvalid()) {return false;}
+  std::cout << fen << std::endl;
+
+  if (divide && depth > 0) {
+    MoveList legal;
+    cb.generate_legal(legal);
+    char buf[notationsize];
+    for (packedmove m : legal) {
+      ChessBitboard::writeuci(m, buf);
+      std::cout << buf << ": " << cb.perft(m, depth - 1) << std::endl;
+    }
+  }
+
+  std::uint64_t nodes;
+  double secs = timedperft(cb, depth, nodes);
+  printrate(depth, nodes, secs);
+  std::cout << std::endl;
+  return true;
+}
+
+void printusage() {
+  std::cout << "Usage: yagchess-perft [--divide] [depth [FEN]]" << std::endl;
+  std::cout << "Without arguments, run the standard perft suite and check the counts." << std::endl;
+  std::cout << "With a depth, count the move sequences of the given FEN position (the start position if not given)." << std::endl;
+  std::cout << "  --divide    also write the count for each legal move of the position" << std::endl;
+}
+
+//main function, run the suite or a single position
+int main(int argc, char *argv[]) {
+  bool divide = false;
+  int depth = -1;
+  std::string fen = perftsuite[0].fen;
+
+  for (int i = 1; i < argc; i++) {
+    std::string cuarg = argv[i];
+    if (cuarg == "--help") {printusage(); return 0;}
+    else if (cuarg == "--divide") {divide = true;}
+    else if (depth == -1) {
+      try {depth = std::stoi(cuarg);}
+      catch (const std::invalid_argument& e) {printusage(); return 1;}
+    }
+    else {fen = cuarg;}
+  }
+
+  if (depth == -1) {return runsuite() ? 0 : 1;}
+  return runposition(fen, depth, divide) ? 0 : 1;
+}
@@ -26,9 +26,9 @@
 #define CHESSBASE_H_DEF 1
 
 #include <iostream>
+#include <array>
 #include <string>
 #include <vector>
-#include <functional>
 #include <unordered_map>
 
 #include "chess_dconst.hpp"
@@ -36,55 +36,18 @@
 /* Association with identifiers and pieces 
  */
 struct ChessIdentifiers {
-  static std::string pgen;
-  static std::string ppaw;
-  static std::string pro;
-  static std::string pkn;
-  static std::string pbi;
-  static std::string pqu;
-  static std::string pki;
+  static const std::string pgen;
+  static const std::string ppaw;
+  static const std::string pro;
+  static const std::string pkn;
+  static const std::string pbi;
+  static const std::string pqu;
+  static const std::string pki;
   
   typedef std::unordered_map<std::string, wpiece> hashidtype;
-  static hashidtype arrpid;
+  static const hashidtype arrpid;
 };
 
-/* Class holding as static members the symbols used in FEN notation
- */
-class ChessFEN {
-  public:
-    static std::string pw;
-    static std::string pb;
-    static std::string rw;
-    static std::string rb;
-    static std::string nw;
-    static std::string nb;
-    static std::string bw;
-    static std::string bb;
-    static std::string qw;
-    static std::string qb;
-    static std::string kw;
-    static std::string kb;
-
-    struct IdPair {
-      public:
-        wpiece pi;
-        c_color col;
-        
-        IdPair(wpiece a, c_color b) : pi{a}, col{b} {}
-        
-        bool operator== (const IdPair&);
-    };
-    
-    typedef std::unordered_map<std::string, IdPair> hashfenid;
-    static hashfenid fenidtable;
-    
-    static std::string getkeyofval(IdPair);
-};
-
-/* Non member overload operator for get opposite color
- */
-c_color operator ! (const c_color);
-
 /* 2D vector arithmetic with limits
  */
 class CHVector {
@@ -93,10 +56,10 @@ class CHVector {
     int y;
         
   public:
-    static int min_x;
-    static int max_x;
-    static int min_y;
-    static int max_y;
+    static constexpr int min_x = MINX;
+    static constexpr int max_x = MAXX;
+    static constexpr int min_y = MINY;
+    static constexpr int max_y = MAXY;
     
     CHVector();
     CHVector(int, int, bool);
@@ -110,199 +73,58 @@ class CHVector {
     int getx(void) {return x;}
     int gety(void) {return y;}
     
-    bool isinvalid(void);
+    bool isinvalid(void) {return x == -1 && y == -1;}
+    
+    //a coordinate outside the chessboard wraps to a large unsigned number, so each axis needs a single compare
+    static bool isonboard(int a, int b) {return static_cast<unsigned int>(a - MINX) < MAXX - MINX && static_cast<unsigned int>(b - MINY) < MAXY - MINY;}
     
     CHVector reverse(void) {return CHVector(x, -y, false);}
     void setvalues(int, int, bool);
 };
 
-/* A Generic chess piece
+/* A chess piece, a value holding type, color and position: the rules of the pieces are in the static tables of ChessBitboard
  */
 class Piece : public CHVector {
   protected:
     wpiece idpi;
-    std::string nalg;
     int num_id; //numeric id of the piece, used to discriminate pieces of same type and color
     c_color color;
-        
-    std::string icon; //will store the address of the image for the gui implementation
-    std::vector<std::vector<CHVector>>* moves;
-    std::vector<std::vector<CHVector>>* eating;
-    std::vector<std::vector<CHVector>>* specials;
      
   public:
     bool ongame = true;
     bool beenmoved = false;
     
     Piece();
-    Piece(c_color); 
-    Piece(c_color, int, int);
+    Piece(wpiece, c_color, int, int, int = 0);
     virtual ~Piece();
 
     wpiece getidtype(void) {return idpi;}
     std::string getidtxt(void);
-    std::string getnalg(void) {return nalg;}
+    std::string getnalg(void);
     int getnumid(void) {return num_id;}
     c_color getcolor(void) {return color;}
-    c_color getoppcolor(void);
-    CHVector getmoves(int, int);
-    CHVector geteating(int, int);
-    CHVector getspecials(int, int);
-    
-    unsigned int moves_directions(void) {return moves->size();}
-    unsigned int moves_steps(int i) {std::vector<CHVector> v = moves->at(i); return v.size();}
-    
-    unsigned int eating_directions(void) {return eating->size();}
-    unsigned int eating_steps(int i) {std::vector<CHVector> v = eating->at(i); return v.size();}
-    
-    unsigned int specials_directions(void) {return specials->size();}
-    unsigned int specials_steps(int i) {std::vector<CHVector> v = specials->at(i); return v.size();}
-    
-    void seticon(void);
-    std::string geticon(void) {return icon;}
-    
-    friend std::ostream& operator<<(std::ostream&, const Piece&); //this is a function, non a method of this class, but declared here as friend allows it to access the private member of this class
-    //~ friend std::istream& operator>>(std::istream&, Piece&);
-    
-    //function wrappers
-    std::function<unsigned int (void)> wrdirection; //Will contains moves_direction / eating_direction / specials_direction according to the required action.
-    std::function<unsigned int (int)> wrsteps; //Will contains moves_steps / eating_steps / specials_steps according to the required action.
-    std::function<CHVector (int, int)> getaction; //Will contains getmoves / geteating / getspecials according to the required action.
-    
-    void assign_methods(int); //0: null target - 1: move - 2: eating - 3: special move 
-    
-    virtual void link_moveat(void) =0;
-
+    c_color getoppcolor(void) {return !color;}
+    std::string geticon(void); //the image for the gui implementation
+    void promote(wpiece, int);
 };
 
-/* The various pieces of chess game, class declarations
+/* List of the pieces of a game with a fixed capacity, the pieces are stored by value so that no memory is allocated when they are placed or removed.
+ * Eated pieces stay in the list with ongame false and a promoted pawn changes its type in place, one slot for each square is a safe bound.
+ * Pointers to the pieces are stable until a piece is erased.
  */
-
-//pawn
-class ChessPawn : public Piece {
-  private: 
-    static std::vector<std::vector<CHVector>> smoves;
-    static std::vector<std::vector<CHVector>> seating;
-    static std::vector<std::vector<CHVector>> sspecials;
-    
-    static int whcounter;
-    static int blcounter;
-    
-  public:
-    ChessPawn(c_color, int, int);
-    ChessPawn(int, c_color, bool, bool, int, int);
-    ~ChessPawn();
-
-    static int getcounter(c_color);
-    bool promoteme(void);
-
-    void link_moveat(void) override;
-};
-
-//rock
-class ChessRock : public Piece {
+class ChessPieceList {
   private:
-    static std::vector<std::vector<CHVector>> smoves;
+    std::array<Piece, MAXX * MAXY> items;
+    unsigned int npieces = 0;
     
-    static int whcounter;
-    static int blcounter;
-
   public:
-    ChessRock(c_color, int, int);
-    ChessRock(int, c_color, bool, bool, int, int);
-    ~ChessRock();
-
-    static int getcounter(c_color);
-    void link_moveat(void) override;
-};
-
-//knight
-class ChessKnight : public Piece {
-  private:
-    static std::vector<std::vector<CHVector>> smoves;
-    
-    static int whcounter;
-    static int blcounter;
-  
-  public:
-    ChessKnight(c_color, int, int);
-    ChessKnight(int, c_color, bool, bool, int, int);
-    ~ChessKnight();
-
-    static int getcounter(c_color);
-    void link_moveat(void) override;
-};
-
-//bishop
-class ChessBishop : public Piece {
-  private:
-    static std::vector<std::vector<CHVector>> smoves;
-    
-    static int whcounter;
-    static int blcounter;
-  
-  public:
-    ChessBishop(c_color, int, int);
-    ChessBishop(int, c_color, bool, bool, int, int);
-    ~ChessBishop();
-    
-    static int getcounter(c_color);
-    void link_moveat(void) override;
-};
-
-//queen
-class ChessQueen : public Piece {
-  private:
-    static std::vector<std::vector<CHVector>> smoves;
-    
-    static int whcounter;
-    static int blcounter;
-  
-  public:
-    ChessQueen(c_color, int, int);
-    ChessQueen(int, c_color, bool, bool, int, int);
-    ~ChessQueen();
-    
-    static int getcounter(c_color);
-    void link_moveat(void) override;
-};
-
-//king
-class ChessKing : public Piece {
-  private:
-    static std::vector<std::vector<CHVector>> smoves;
-    static std::vector<std::vector<CHVector>> sspecials;
-    
-    static int whcounter;
-    static int blcounter;
-  
-  public:
-    ChessKing(c_color, int, int);
-    ChessKing(int, c_color, bool, bool, int, int);
-    ~ChessKing();
-    
-    static int getcounter(c_color);
-    void link_moveat(void) override;
-};
-
-//fakepawn, just a placeholder to allow pawn eating en passant 
-class ChessFakePawn : public Piece {
-  private:
-    static std::vector<std::vector<CHVector>> smoves;
-    static int fakecounter;
-    
-    ChessPawn* refpawn;
-    
-  public:
-    ChessFakePawn(c_color, int, int, ChessPawn*);
-    ChessFakePawn(int, c_color, bool, bool, int, int);
-    ChessFakePawn(ChessFakePawn*, ChessPawn*);
-    ChessFakePawn(ChessPawn*);
-    ~ChessFakePawn();
-    void link_moveat(void) override;
-    
-    static int getcounter(void) {return fakecounter;}
-    ChessPawn* getrefp(void) {return refpawn;}
+    void clear(void) {npieces = 0;}
+    Piece* add(const Piece&);
+    void erase(unsigned int);
+    unsigned int size(void) const {return npieces;}
+    int count(wpiece, c_color);
+    Piece* operator[] (unsigned int i) {return &items[i];}
+    const Piece* operator[] (unsigned int i) const {return &items[i];}
 };
 
 /* Class for chess input/output coordinates, made of static attributes and methods only, no need to create object of this class, as its attributes do not change
@@ -312,8 +134,8 @@ class ChessCoordinates {
   public: typedef std::array<char, MAXY> ylarray;
 
   private:
-    static xlarray xletters;
-    static ylarray ynumbers;
+    static const xlarray xletters;
+    static const ylarray ynumbers;
     
     template <typename T> static int genin(std::string, T);
     
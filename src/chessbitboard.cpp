@@ -0,0 +1,1068 @@
+/*
+ * chessbitboard.cpp
+ * 
+ * Copyright 2017 Valentino Esposito <valentinoe85@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+
+#include <cctype> //for std::isalpha function
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#include "chessbitboard.hpp"
+
+/* Magic multipliers of the rocks and of the bishops, one for each square.
+ * They have been found by a random search of sparse numbers mapping each occupancy subset with different attacks to a different index.
+ */
+const std::array<bitboard, MAXX * MAXY> rockmagicnumbers = {{
+  0x008000908064C000ULL, 0x0040200040001000ULL, 0x0180100080A0010AULL, 0x8880041000800800ULL,
+  0x1200100201200804ULL, 0x0200020004011008ULL, 0x2180010000800600ULL, 0x0200005088210204ULL,
+  0x0400800040008021ULL, 0x0400400020005000ULL, 0x8240801000200080ULL, 0x8611001004200900ULL,
+  0x008180800C001800ULL, 0x0100800200800400ULL, 0x0A02000102000408ULL, 0x8020802300104280ULL,
+  0x0080004000402000ULL, 0xE010104000402000ULL, 0x0800808010002000ULL, 0xA280210008100100ULL,
+  0x0001818014000800ULL, 0xA002010100080400ULL, 0x0080240001020870ULL, 0x0001020004048845ULL,
+  0x0081826280004004ULL, 0x2020810900284000ULL, 0x0200100080802000ULL, 0x0200080080100080ULL,
+  0x8083080100100500ULL, 0x4406000901000400ULL, 0x0005020080800100ULL, 0x0090204200008114ULL,
+  0x0010400094800420ULL, 0x0900804000802002ULL, 0x0201001841002000ULL, 0x4100080080801000ULL,
+  0x4540040080800800ULL, 0x0002001004040020ULL, 0x0281195814001002ULL, 0x1240800040800100ULL,
+  0x0880042000524004ULL, 0x02C080410206002CULL, 0x0801200241050010ULL, 0x8400080010008080ULL,
+  0x0008000500090010ULL, 0x0082009084020008ULL, 0x4012000108020004ULL, 0x9000104D08860004ULL,
+  0x2004204114800100ULL, 0x0148802112400300ULL, 0x0202842000100880ULL, 0x001B080080900080ULL,
+  0x001A002008100600ULL, 0x0004008004020080ULL, 0x5181000600040300ULL, 0x0000044401128A00ULL,
+  0x8044110480002441ULL, 0x2008110084402202ULL, 0x90806005090010C1ULL, 0x000420310A004A42ULL,
+  0x0023001004020801ULL, 0x0882001008040102ULL, 0x000230088118020CULL, 0x0000019025040042ULL
+}};
+
+const std::array<bitboard, MAXX * MAXY> bishopmagicnumbers = {{
+  0x0020428400408200ULL, 0x2008010104210004ULL, 0x02D0009200480190ULL, 0x0018158B00010100ULL,
+  0x02C4042132048008ULL, 0x020082202000C221ULL, 0x4000421050080009ULL, 0x0210140202022020ULL,
+  0x00C0101410042248ULL, 0x0405204800D48080ULL, 0x3800C89200420002ULL, 0x180844124A020440ULL,
+  0x04403410A8002221ULL, 0x4040209004200400ULL, 0x084004020202A204ULL, 0x3010002104022000ULL,
+  0x00200240A9110900ULL, 0x2302800404080210ULL, 0x0204188800240010ULL, 0x8048000C01401200ULL,
+  0x120C001A11040900ULL, 0x0000401200500440ULL, 0x00004040840420A0ULL, 0x0020930822880804ULL,
+  0x4044401090900161ULL, 0x0034100015210804ULL, 0x8004100009010120ULL, 0x48C8080000820500ULL,
+  0x0080848004002000ULL, 0x0801004012005044ULL, 0x000080902C040400ULL, 0x0004009005004100ULL,
+  0x0B103010048A0200ULL, 0x8004100203181A00ULL, 0x0800140200100080ULL, 0x8401010800910040ULL,
+  0x0840010011290040ULL, 0x40100214202E1000ULL, 0x0842040040010840ULL, 0x0028010040010860ULL,
+  0x00080202A2051000ULL, 0x4200841008084204ULL, 0x0021120110000D02ULL, 0x48C1004208000084ULL,
+  0x0010088100414400ULL, 0x0021101000420580ULL, 0x0010040558401410ULL, 0x200C0C82A1050205ULL,
+  0x0011108820088000ULL, 0x0001011910120402ULL, 0x1580008608091248ULL, 0x8010018020880C02ULL,
+  0x20A1101032088480ULL, 0x0080100408082800ULL, 0x28100401140401C0ULL, 0x8002102200930012ULL,
+  0x4001040082080200ULL, 0x082200A498081808ULL, 0x000508610080D003ULL, 0x0052020044842402ULL,
+  0x4800A00140C84840ULL, 0x5000000848080820ULL, 0x0101086004240040ULL, 0x0028280808005014ULL
+}};
+
+/* ChessMagic methods
+ */
+//index of the occupancy in the attack table of the square
+unsigned int ChessMagic::index(bitboard occ) const {
+#ifdef __BMI2__
+  return static_cast<unsigned int>(_pext_u64(occ, mask));
+#else
+  return static_cast<unsigned int>(((occ & mask) * magic) >> shift);
+#endif
+}
+
+/* ChessBitboard static members
+ */
+constexpr int ChessGeometry<knight>::steps[][2];
+constexpr int ChessGeometry<king>::steps[][2];
+constexpr int ChessGeometry<pawn, white>::steps[][2];
+constexpr int ChessGeometry<pawn, black>::steps[][2];
+constexpr int ChessGeometry<rock>::steps[][2];
+constexpr int ChessGeometry<bishop>::steps[][2];
+
+constexpr ChessStepTable ChessBitboard::knighttable;
+constexpr ChessStepTable ChessBitboard::kingtable;
+constexpr ChessStepTable ChessBitboard::pawntable[2];
+std::array<ChessMagic, MAXX * MAXY> ChessBitboard::rockmagics;
+std::array<ChessMagic, MAXX * MAXY> ChessBitboard::bishopmagics;
+std::array<bitboard, 102400> ChessBitboard::rocktable;
+std::array<bitboard, 5248> ChessBitboard::bishoptable;
+std::array<std::array<bitboard, MAXX * MAXY>, MAXX * MAXY> ChessBitboard::betweentable;
+std::array<std::array<bitboard, MAXX * MAXY>, MAXX * MAXY> ChessBitboard::linetable;
+std::array<std::array<std::array<std::uint64_t, MAXX * MAXY>, 7>, 2> ChessBitboard::zpieces;
+std::array<std::uint64_t, 16> ChessBitboard::zcastling;
+std::array<std::uint64_t, MAXX> ChessBitboard::zepfile;
+std::uint64_t ChessBitboard::zside;
+
+/* ChessBitboard methods
+ */
+ChessBitboard::ChessBitboard() {readytables(); clear();}
+
+//remove all the pieces
+void ChessBitboard::clear() {
+  bycolor.fill(0);
+  bytype.fill(0);
+  epsquare = -1;
+  side = white;
+  castling = 0;
+  halfmove = 0;
+  fullmove = 1;
+  key = 0;
+  material = 0;
+}
+
+//place a piece in an empty square, the hash key and the material key are not updated: use computekey when the position is complete
+void ChessBitboard::putpiece(wpiece w, c_color c, int sq) {
+  bycolor[c] |= sqbit(sq);
+  bytype[w] |= sqbit(sq);
+}
+
+//the part of the hash key given by the en passant square, only if a pawn of the player who moves can eat there
+std::uint64_t ChessBitboard::epkey() const {
+  if (epsquare == -1 || (! (pawnattacks(!side, epsquare) & pieces(side, pawn)))) {return 0;}
+  return zepfile[sqfile(epsquare)];
+}
+
+//compute the hash key and the material key from scratch
+void ChessBitboard::computekey() {
+  key = 0;
+  material = 0;
+  for (int c = black; c <= white; c++) {
+    for (int w = pawn; w <= king; w++) {
+      bitboard pcs = bycolor[c] & bytype[w];
+      material += materialkey(bbcount(pcs)) << materialshift(static_cast<wpiece>(w), static_cast<c_color>(c));
+      while (pcs) {key ^= zpieces[c][w][bbpopfirst(pcs)];}
+    }
+  }
+  key ^= zcastling[castling] ^ epkey();
+  if (side == white) {key ^= zside;}
+}
+
+//castling possibilities lost when a piece leaves or reaches a square (the starting squares of kings and rocks)
+static int castlingloss(int sq) {
+  if (sq == sqindex(0, 0)) {return blqueenside;}
+  else if (sq == sqindex(4, 0)) {return blkingside | blqueenside;}
+  else if (sq == sqindex(7, 0)) {return blkingside;}
+  else if (sq == sqindex(0, 7)) {return whqueenside;}
+  else if (sq == sqindex(4, 7)) {return whkingside | whqueenside;}
+  else if (sq == sqindex(7, 7)) {return whkingside;}
+  return 0;
+}
+
+//get the type of piece in a square, generic if the square is empty
+wpiece ChessBitboard::typeat(int sq) const {
+  bitboard b = sqbit(sq);
+  for (int w = pawn; w <= king; w++) {
+    if (bytype[w] & b) {return static_cast<wpiece>(w);}
+  }
+  return generic;
+}
+
+//get the square of the king, -1 if the king is not on the chessboard
+int ChessBitboard::kingsquare(c_color c) const {
+  bitboard k = pieces(c, king);
+  if (k == 0) {return -1;}
+  return bbfirst(k);
+}
+
+//fill the attack table of a sliding piece, storing the attacks for each subset of the relevant occupancy mask of each square
+template <wpiece W> void ChessBitboard::initsliders(std::array<ChessMagic, MAXX * MAXY>& magics, bitboard* table, const std::array<bitboard, MAXX * MAXY>& magicnumbers) {
+  unsigned int offset = 0;
+
+  for (int sq = 0; sq < MAXX * MAXY; sq++) {
+    ChessMagic& mg = magics[sq];
+
+    //the squares on the edges of the chessboard never block a ray, unless the piece stands on the same edge
+    bitboard edges = 0;
+    for (int i = 0; i < MAXX; i++) {
+      if (sqrow(sq) != MINY) {edges |= sqbit(sqindex(i, MINY));}
+      if (sqrow(sq) != MAXY -1) {edges |= sqbit(sqindex(i, MAXY -1));}
+    }
+    for (int j = 0; j < MAXY; j++) {
+      if (sqfile(sq) != MINX) {edges |= sqbit(sqindex(MINX, j));}
+      if (sqfile(sq) != MAXX -1) {edges |= sqbit(sqindex(MAXX -1, j));}
+    }
+    mg.mask = rayattacks<W>(sq, 0) & ~edges;
+    mg.magic = magicnumbers[sq];
+    mg.shift = 64 - bbcount(mg.mask);
+    mg.offset = offset;
+
+    //enumerating all the subsets of the mask
+    bitboard sub = 0;
+    do {
+      table[offset + mg.index(sub)] = rayattacks<W>(sq, sub);
+      sub = (sub - mg.mask) & mg.mask;
+    } while (sub);
+
+    offset += 1u << bbcount(mg.mask);
+  }
+}
+
+//build the attack and hash tables, it is called once by readytables when the first board is constructed
+bool ChessBitboard::inittables() {
+  initsliders<rock>(rockmagics, rocktable.data(), rockmagicnumbers);
+  initsliders<bishop>(bishopmagics, bishoptable.data(), bishopmagicnumbers);
+
+  //squares between and lines through two squares, found by looking from each square toward the other
+  for (int sa = 0; sa < MAXX * MAXY; sa++) {
+    for (int sb = 0; sb < MAXX * MAXY; sb++) {
+      betweentable[sa][sb] = 0;
+      linetable[sa][sb] = 0;
+      if (sa == sb) {continue;}
+      if (rockattacks(sa, 0) & sqbit(sb)) {
+        betweentable[sa][sb] = rockattacks(sa, sqbit(sb)) & rockattacks(sb, sqbit(sa));
+        linetable[sa][sb] = (rockattacks(sa, 0) & rockattacks(sb, 0)) | sqbit(sa) | sqbit(sb);
+      } else if (bishopattacks(sa, 0) & sqbit(sb)) {
+        betweentable[sa][sb] = bishopattacks(sa, sqbit(sb)) & bishopattacks(sb, sqbit(sa));
+        linetable[sa][sb] = (bishopattacks(sa, 0) & bishopattacks(sb, 0)) | sqbit(sa) | sqbit(sb);
+      }
+    }
+  }
+
+  //the random numbers of the hash key, from a xorshift generator with a fixed seed so that the keys are always the same
+  std::uint64_t seed = 0x9E3779B97F4A7C15ULL;
+  auto nextrandom = [&seed]() {
+    seed ^= seed >> 12;
+    seed ^= seed << 25;
+    seed ^= seed >> 27;
+    return seed * 2685821657736338717ULL;
+  };
+  for (auto& zc : zpieces) {
+    for (auto& zw : zc) {
+      for (auto& zsq : zw) {zsq = nextrandom();}
+    }
+  }
+  zcastling[0] = 0;
+  for (unsigned int i = 1; i < zcastling.size(); i++) {zcastling[i] = nextrandom();}
+  for (auto& ze : zepfile) {ze = nextrandom();}
+  zside = nextrandom();
+  return true;
+}
+
+bitboard ChessBitboard::bishopattacks(int sq, bitboard occ) {
+  const ChessMagic& mg = bishopmagics[sq];
+  return bishoptable[mg.offset + mg.index(occ)];
+}
+
+bitboard ChessBitboard::rockattacks(int sq, bitboard occ) {
+  const ChessMagic& mg = rockmagics[sq];
+  return rocktable[mg.offset + mg.index(occ)];
+}
+
+//pieces of color c which can eat in the square sq, given the occupancy occ
+bitboard ChessBitboard::attackers(int sq, c_color c, bitboard occ) const {
+  bitboard res = pawnattacks(!c, sq) & pieces(c, pawn); //a pawn eating in sq stands where a pawn of the other color in sq would eat
+  res |= knightattacks(sq) & pieces(c, knight);
+  res |= kingattacks(sq) & pieces(c, king);
+  res |= bishopattacks(sq, occ) & (bytype[bishop] | bytype[queen]) & bycolor[c];
+  res |= rockattacks(sq, occ) & (bytype[rock] | bytype[queen]) & bycolor[c];
+  return res;
+}
+
+/* pieces of color c menacing the square sq, the integer selmet follows the notation of Piece::assign_methods:
+ * 1 for moving in the square, 2 for eating in the square, 3 for a special move (first move of pawns and king).
+ * The pieces of color c eating in sq are given by att, as found by attackers or by an attack map.
+ */
+bitboard ChessBitboard::menacers(int sq, c_color c, int selmet, bitboard att) const {
+  bitboard res = 0;
+  bitboard occ = occupied();
+  int back = (c == white) ? MAXX : -MAXX; //a pawn of color c reaches sq from this offset
+
+  if (selmet == 2) {res = att;}
+  else if (selmet == 1) {
+    res = att & ~bytype[pawn];
+    int from = sq + back;
+    if (from >= 0 && from < MAXX * MAXY) {res |= sqbit(from) & pieces(c, pawn);}
+  } else if (selmet == 3) {
+    //pawn moving by one or two squares on its first move
+    int froma = sq + back;
+    int fromb = sq + 2 * back;
+    if (froma >= 0 && froma < MAXX * MAXY) {
+      res |= sqbit(froma) & pieces(c, pawn);
+      if (fromb >= 0 && fromb < MAXX * MAXY && (! (occ & sqbit(froma)))) {res |= sqbit(fromb) & pieces(c, pawn);}
+    }
+
+    //king moving by one or two squares along its row for castling
+    int ksq = kingsquare(c);
+    if (ksq != -1 && sqrow(ksq) == sqrow(sq)) {
+      int dist = sqfile(sq) - sqfile(ksq);
+      if (dist == 1 || dist == -1) {res |= sqbit(ksq);}
+      else if ((dist == 2 || dist == -2) && (! (occ & sqbit(ksq + dist / 2)))) {res |= sqbit(ksq);}
+    }
+  }
+
+  return res;
+}
+
+//spread the eating squares of the pieces of type W and color c in the attack map
+template <wpiece W> void ChessBitboard::spreadattacks(c_color c, bitboard occ, ChessAttackMap& am) const {
+  bitboard pcs = pieces(c, W);
+  while (pcs) {
+    int from = bbpopfirst(pcs);
+    bitboard targets = attacks<W>(from, occ);
+    am.attacked |= targets;
+    while (targets) {am.attackers[bbpopfirst(targets)] |= sqbit(from);}
+  }
+}
+
+//fill the attack map of color c, spreading the eating squares of each piece of the color
+void ChessBitboard::fillattackmap(c_color c, ChessAttackMap& am) const {
+  bitboard occ = occupied();
+  am.attacked = 0;
+  am.attackers.fill(0);
+
+  bitboard pp = pieces(c, pawn);
+  while (pp) {
+    int from = bbpopfirst(pp);
+    bitboard targets = pawnattacks(c, from);
+    am.attacked |= targets;
+    while (targets) {am.attackers[bbpopfirst(targets)] |= sqbit(from);}
+  }
+  spreadattacks<rock>(c, occ, am);
+  spreadattacks<knight>(c, occ, am);
+  spreadattacks<bishop>(c, occ, am);
+  spreadattacks<queen>(c, occ, am);
+  spreadattacks<king>(c, occ, am);
+  am.key = key;
+  am.ready = true;
+}
+
+/* squares reached by a piece of type w and color c standing in sq, the integer selmet follows the notation of Piece::assign_methods.
+ * Along a path, the first occupied square is included whatever is the color of the piece in it.
+ */
+bitboard ChessBitboard::actions(wpiece w, c_color c, int sq, int selmet) const {
+  bitboard occ = occupied();
+  int ahead = (c == white) ? -MAXX : MAXX; //the offset of a pawn step of color c
+
+  if (w == pawn) {
+    int toa = sq + ahead;
+    if (toa < 0 || toa >= MAXX * MAXY) {return 0;}
+    if (selmet == 1) {return sqbit(toa);}
+    else if (selmet == 2) {return pawnattacks(c, sq);}
+    else if (selmet == 3) {
+      int tob = toa + ahead;
+      if ((occ & sqbit(toa)) || tob < 0 || tob >= MAXX * MAXY) {return sqbit(toa);}
+      return sqbit(toa) | sqbit(tob);
+    }
+    return 0;
+  }
+
+  if (selmet == 3) {
+    if (w != king) {return 0;}
+    //the king moves by one or two squares along its row
+    bitboard res = 0;
+    for (int d = -1; d <= 1; d += 2) {
+      for (int k = 1; k <= 2; k++) {
+        int x = sqfile(sq) + d * k;
+        if (x < MINX || x >= MAXX) {break;}
+        res |= sqbit(sqindex(x, sqrow(sq)));
+        if (occ & sqbit(sqindex(x, sqrow(sq)))) {break;}
+      }
+    }
+    return res;
+  }
+
+  switch (w) {
+    case rock: return attacks<rock>(sq, occ);
+    case knight: return attacks<knight>(sq, occ);
+    case bishop: return attacks<bishop>(sq, occ);
+    case queen: return attacks<queen>(sq, occ);
+    case king: return attacks<king>(sq, occ);
+    default: return 0;
+  }
+}
+
+//check if the king of color c is eatable
+bool ChessBitboard::incheck(c_color c) const {
+  int ksq = kingsquare(c);
+  if (ksq == -1) {return false;}
+  return attackers(ksq, !c) != 0;
+}
+
+/* compute the checks and the pins against the king of color c.
+ * A piece is pinned if it is the only piece between the king and a rock, bishop or queen of the opponent looking at the king
+ * from an empty chessboard; the king escapes are checked with the king removed, so that it does not cover the squares behind it.
+ */
+ChessCheckInfo ChessBitboard::checkinfo(c_color c) const {
+  ChessCheckInfo info;
+  c_color adv = !c;
+  bitboard occ = occupied();
+  info.kingsq = kingsquare(c);
+  info.checkers = 0;
+  info.evasions = ~bitboard(0);
+  info.pinned = 0;
+  info.kingescapes = 0;
+  if (info.kingsq == -1) {return info;}
+
+  info.checkers = attackers(info.kingsq, adv, occ);
+  if (info.checkers & (info.checkers - 1)) {info.evasions = 0;}
+  else if (info.checkers) {info.evasions = info.checkers | betweentable[info.kingsq][bbfirst(info.checkers)];}
+
+  bitboard snipers = (rockattacks(info.kingsq, 0) & (bytype[rock] | bytype[queen]) & bycolor[adv]) | (bishopattacks(info.kingsq, 0) & (bytype[bishop] | bytype[queen]) & bycolor[adv]);
+  while (snipers) {
+    bitboard inbetween = betweentable[info.kingsq][bbpopfirst(snipers)] & occ;
+    if (inbetween && (! (inbetween & (inbetween - 1)))) {info.pinned |= inbetween & bycolor[c];}
+  }
+
+  bitboard kingcango = kingattacks(info.kingsq) & ~bycolor[c];
+  bitboard occnoking = occ & ~sqbit(info.kingsq);
+  while (kingcango) {
+    int tsq = bbpopfirst(kingcango);
+    if (attackers(tsq, adv, occnoking) == 0) {info.kingescapes |= sqbit(tsq);}
+  }
+  return info;
+}
+
+/* check if neither player can checkmate in any way, with the material key and the bishop squares only:
+ * a king alone, a king and a knight, or kings and bishops all on squares of the same color
+ */
+bool ChessBitboard::insufficientmaterial() const {
+  if (materialcount(material, king, white) != 1 || materialcount(material, king, black) != 1) {return false;} //not a real game position
+  materialkey rest = material - materialunit(king, white) - materialunit(king, black);
+  if (rest == 0 || rest == materialunit(knight, white) || rest == materialunit(knight, black)) {return true;}
+
+  materialkey bishops = (materialkey(0xF) << materialshift(bishop, white)) | (materialkey(0xF) << materialshift(bishop, black));
+  if (rest & ~bishops) {return false;}
+  return (bytype[bishop] & lightsquares) == 0 || (bytype[bishop] & ~lightsquares) == 0;
+}
+
+//check if the player who moves is checkmated: in check and without legal moves
+bool ChessBitboard::ischeckmate() const {
+  ChessCheckInfo info = checkinfo(side);
+  return info.checkers != 0 && (! has_legal_move(info));
+}
+
+//check if the player who moves is stalemated: not in check and without legal moves
+bool ChessBitboard::isstalemate() const {
+  ChessCheckInfo info = checkinfo(side);
+  return info.checkers == 0 && (! has_legal_move(info));
+}
+
+//check if a piece of type W of the player who moves can legally reach one of the targets (free or enemy squares answering the check)
+template <wpiece W> bool ChessBitboard::canmove(bitboard targets, const ChessCheckInfo& info) const {
+  bitboard pcs = pieces(side, W);
+  bitboard occ = occupied();
+  while (pcs) {
+    int from = bbpopfirst(pcs);
+    bitboard reach = attacks<W>(from, occ) & targets;
+    if (info.pinned & sqbit(from)) {reach &= linetable[info.kingsq][from];}
+    if (reach) {return true;}
+  }
+  return false;
+}
+
+/* check if the player who moves has at least a legal move, stopping at the first one found. No move list is built:
+ * the king moves are given by kingescapes (a castling is possible only if the king can also step in the crossed square),
+ * the other pieces must reach a square of evasions and the pinned ones must stay on the line of their king.
+ */
+bool ChessBitboard::has_legal_move(const ChessCheckInfo& info) const {
+  if (info.kingsq == -1) {
+    MoveList pseudo;
+    generate_pseudo(pseudo);
+    return pseudo.size() > 0;
+  }
+  if (info.kingescapes) {return true;}
+  if (info.evasions == 0) {return false;} //double check, only the king could move
+
+  bitboard own = bycolor[side];
+  bitboard enemy = bycolor[!side];
+  bitboard occ = own | enemy;
+  bitboard targets = info.evasions & ~own;
+  if (canmove<knight>(targets, info) || canmove<bishop>(targets, info) || canmove<rock>(targets, info) || canmove<queen>(targets, info)) {return true;}
+
+  int ahead = (side == white) ? -MAXX : MAXX;
+  int startrow = (side == white) ? MAXY -2 : MINY +1;
+  bitboard pp = pieces(side, pawn);
+  while (pp) {
+    int from = bbpopfirst(pp);
+    int to = from + ahead;
+    bitboard reach = pawnattacks(side, from) & enemy;
+    if (! (occ & sqbit(to))) {
+      reach |= sqbit(to);
+      if (sqrow(from) == startrow && (! (occ & sqbit(to + ahead)))) {reach |= sqbit(to + ahead);}
+    }
+    reach &= targets;
+    if (info.pinned & sqbit(from)) {reach &= linetable[info.kingsq][from];}
+    if (reach) {return true;}
+    if (epsquare != -1 && (pawnattacks(side, from) & sqbit(epsquare)) && (pieces(!side, pawn) & sqbit(epsquare - ahead))) {
+      if (islegal(packmove(from, epsquare, enpassant), info)) {return true;}
+    }
+  }
+  return false;
+}
+
+/* build the packed move of the piece in the starting square, as the rules of the pieces make it:
+ * the kind of move is deduced from the pieces in the squares, the promoted piece is used if a pawn reaches the last row.
+ * The move is not checked.
+ */
+packedmove ChessBitboard::buildmove(int from, int to, wpiece prom) const {
+  wpiece w = typeat(from);
+  c_color c = colorat(from);
+  int k = (bycolor[!c] & sqbit(to)) ? eatmove : quietmove;
+
+  if (w == pawn) {
+    if (to == epsquare && k == quietmove && sqfile(to) != sqfile(from)) {k = enpassant;}
+    else if (to - from == 2 * MAXX || from - to == 2 * MAXX) {k = doublepush;}
+    else if (sqrow(to) == MINY || sqrow(to) == MAXY -1) {
+      const int promk[7] = {quietmove, quietmove, promorock, promoknight, promobishop, promoqueen, quietmove};
+      k |= promk[prom];
+    }
+  } else if (w == king) {
+    if (to - from == 2) {k = kingcastling;}
+    else if (from - to == 2) {k = queencastling;}
+  }
+  return packmove(from, to, k);
+}
+
+/* perform a move on the bitboards: the rock is moved in the castling, the pawn is removed in the en passant eating,
+ * the promoted piece replaces the pawn. The en passant square, the castling possibilities, the halfmove counter
+ * and the player who moves are updated. What is needed to undo the move is written in undo. The move is not checked.
+ */
+void ChessBitboard::make_move(packedmove m, ChessUndo& undo) {
+  int from = movefrom(m);
+  int to = moveto(m);
+  int k = movekindof(m);
+  c_color adv = !side;
+  int back = (side == white) ? MAXX : -MAXX; //offset of the square behind the arrival square of a pawn
+  wpiece w = typeat(from);
+
+  undo.castling = castling;
+  undo.epsquare = epsquare;
+  undo.halfmove = halfmove;
+  undo.key = key;
+  undo.material = material;
+  undo.eated = generic;
+  key ^= zcastling[castling] ^ epkey() ^ zside; //the old parts of the key depending on the state are removed
+  if (k == enpassant) {
+    undo.eated = pawn;
+    toggle(pawn, adv, to + back);
+  } else if (bycolor[adv] & sqbit(to)) {
+    undo.eated = typeat(to);
+    toggle(undo.eated, adv, to);
+  }
+  if (undo.eated != generic) {material -= materialunit(undo.eated, adv);}
+
+  toggle(w, side, from);
+  if (ispromotion(m)) {
+    toggle(promotedpiece(m), side, to);
+    material += materialunit(promotedpiece(m), side) - materialunit(pawn, side);
+  }
+  else {toggle(w, side, to);}
+  if (k == kingcastling) {toggle(rock, side, to + 1); toggle(rock, side, to - 1);}
+  else if (k == queencastling) {toggle(rock, side, to - 2); toggle(rock, side, to + 1);}
+
+  castling &= ~(castlingloss(from) | castlingloss(to));
+  epsquare = (k == doublepush) ? to + back : -1;
+  halfmove = (w == pawn || undo.eated != generic) ? 0 : halfmove + 1;
+  if (side == black) {fullmove++;}
+  side = adv;
+  key ^= zcastling[castling] ^ epkey(); //zside was xored above, as the key flips on each move
+}
+
+//undo a move done with make_move, restoring the state saved in undo
+void ChessBitboard::unmake_move(packedmove m, const ChessUndo& undo) {
+  int from = movefrom(m);
+  int to = moveto(m);
+  int k = movekindof(m);
+  side = !side;
+  int back = (side == white) ? MAXX : -MAXX;
+  wpiece w = typeat(to);
+
+  toggle(w, side, to);
+  if (ispromotion(m)) {toggle(pawn, side, from);}
+  else {toggle(w, side, from);}
+  if (k == kingcastling) {toggle(rock, side, to + 1); toggle(rock, side, to - 1);}
+  else if (k == queencastling) {toggle(rock, side, to - 2); toggle(rock, side, to + 1);}
+
+  if (k == enpassant) {toggle(pawn, !side, to + back);}
+  else if (undo.eated != generic) {toggle(undo.eated, !side, to);}
+
+  castling = undo.castling;
+  epsquare = undo.epsquare;
+  halfmove = undo.halfmove;
+  if (side == black) {fullmove--;}
+  key = undo.key;
+  material = undo.material;
+}
+
+//add the moves of a pawn, with the four promotions if the pawn reaches the last row
+void ChessBitboard::addpawnmoves(MoveList& ml, int from, int to, bool iseat) const {
+  if (sqrow(to) == MINY || sqrow(to) == MAXY -1) {
+    int eatk = iseat ? eatmove : quietmove;
+    ml.add(packmove(from, to, promoqueen | eatk));
+    ml.add(packmove(from, to, promoknight | eatk));
+    ml.add(packmove(from, to, promorock | eatk));
+    ml.add(packmove(from, to, promobishop | eatk));
+  } else {
+    ml.add(packmove(from, to, iseat ? eatmove : quietmove));
+  }
+}
+
+//add the moves of the pieces of type W of the player who moves, given the pieces of the player and of the opponent
+template <wpiece W> void ChessBitboard::addpiecemoves(MoveList& ml, bitboard own, bitboard enemy) const {
+  bitboard pcs = own & bytype[W];
+  while (pcs) {
+    int from = bbpopfirst(pcs);
+    bitboard targets = attacks<W>(from, own | enemy) & ~own;
+    while (targets) {
+      int to = bbpopfirst(targets);
+      ml.add(packmove(from, to, (enemy & sqbit(to)) ? eatmove : quietmove));
+    }
+  }
+}
+
+//generate the moves of the player who moves, without checking if the king is left in check (except for the castling)
+void ChessBitboard::generate_pseudo(MoveList& ml) const {
+  c_color adv = !side;
+  bitboard occ = occupied();
+  bitboard own = bycolor[side];
+  bitboard enemy = bycolor[adv];
+  int ahead = (side == white) ? -MAXX : MAXX;
+  int startrow = (side == white) ? MAXY -2 : MINY +1;
+
+  //pawns
+  bitboard pp = pieces(side, pawn);
+  while (pp) {
+    int from = bbpopfirst(pp);
+    int to = from + ahead;
+    if (! (occ & sqbit(to))) {
+      addpawnmoves(ml, from, to, false);
+      if (sqrow(from) == startrow && (! (occ & sqbit(to + ahead)))) {ml.add(packmove(from, to + ahead, doublepush));}
+    }
+    bitboard eats = pawnattacks(side, from) & enemy;
+    while (eats) {addpawnmoves(ml, from, bbpopfirst(eats), true);}
+    if (epsquare != -1 && (pawnattacks(side, from) & sqbit(epsquare)) && (pieces(adv, pawn) & sqbit(epsquare - ahead))) {
+      ml.add(packmove(from, epsquare, enpassant));
+    }
+  }
+
+  //other pieces
+  addpiecemoves<rock>(ml, own, enemy);
+  addpiecemoves<knight>(ml, own, enemy);
+  addpiecemoves<bishop>(ml, own, enemy);
+  addpiecemoves<queen>(ml, own, enemy);
+  addpiecemoves<king>(ml, own, enemy);
+
+  //castling: the squares between king and rock must be empty, the king cannot be in check in its starting, crossed and arrival squares
+  int row = (side == white) ? MAXY -1 : MINY;
+  int ksq = sqindex(4, row);
+  int kside = (side == white) ? whkingside : blkingside;
+  int qside = (side == white) ? whqueenside : blqueenside;
+  if ((castling & (kside | qside)) && (pieces(side, king) & sqbit(ksq)) && (! isattacked(ksq, adv))) {
+    if ((castling & kside) && (pieces(side, rock) & sqbit(ksq + 3)) && (! (occ & (sqbit(ksq + 1) | sqbit(ksq + 2))))) {
+      if ((! isattacked(ksq + 1, adv)) && (! isattacked(ksq + 2, adv))) {ml.add(packmove(ksq, ksq + 2, kingcastling));}
+    }
+    if ((castling & qside) && (pieces(side, rock) & sqbit(ksq - 4)) && (! (occ & (sqbit(ksq - 1) | sqbit(ksq - 2) | sqbit(ksq - 3))))) {
+      if ((! isattacked(ksq - 1, adv)) && (! isattacked(ksq - 2, adv))) {ml.add(packmove(ksq, ksq - 2, queencastling));}
+    }
+  }
+}
+
+/* check if a move generated by generate_pseudo leaves the king of the player who moves safe, using the masks of checkinfo.
+ * The en passant eating removes two pieces from the same row, so it is checked with the occupancy after the move.
+ */
+bool ChessBitboard::islegal(packedmove m, const ChessCheckInfo& info) const {
+  int from = movefrom(m);
+  int to = moveto(m);
+  int k = movekindof(m);
+  if (info.kingsq == -1) {return true;}
+
+  if (from == info.kingsq) {
+    if (k == kingcastling || k == queencastling) {return true;} //the crossed squares are checked by generate_pseudo
+    return (info.kingescapes & sqbit(to)) != 0;
+  }
+
+  if (k == enpassant) {
+    int eated = to + ((side == white) ? MAXX : -MAXX);
+    bitboard occ = (occupied() ^ sqbit(from) ^ sqbit(eated)) | sqbit(to);
+    return (attackers(info.kingsq, !side, occ) & ~sqbit(eated)) == 0;
+  }
+
+  if (! (info.evasions & sqbit(to))) {return false;}
+  return (! (info.pinned & sqbit(from))) || (linetable[info.kingsq][from] & sqbit(to));
+}
+
+//generate the legal moves of the player who moves: the moves leaving the king in check are excluded by the masks of checkinfo
+void ChessBitboard::generate_legal(MoveList& ml) const {
+  MoveList pseudo;
+  generate_pseudo(pseudo);
+
+  ChessCheckInfo info = checkinfo(side);
+  ml.clear();
+  for (packedmove m : pseudo) {
+    if (islegal(m, info)) {ml.add(m);}
+  }
+}
+
+//check if a move is among the legal moves
+bool ChessBitboard::islegal(packedmove m) const {
+  MoveList legal;
+  generate_legal(legal);
+  for (packedmove lm : legal) {
+    if (lm == m) {return true;}
+  }
+  return false;
+}
+
+//read a move of the player who moves written in short or long algebraic notation (SAN, LAN) or in the UCI notation,
+//the move is found among the legal moves. Get nullmove if no legal move or more than one match the text. No allocation is done.
+packedmove ChessBitboard::parsemove(std::string_view txt) const {
+  //removing the check, checkmate and suffix annotations (+ # ! ?)
+  while (! txt.empty() && (txt.back() == '+' || txt.back() == '#' || txt.back() == '!' || txt.back() == '?' || txt.back() == ' ')) {txt.remove_suffix(1);}
+  if (txt.size() < 2) {return nullmove;}
+
+  MoveList legal;
+  generate_legal(legal);
+
+  //special notation for castling, also written with zeros
+  if (txt == "O-O" || txt == "0-0" || txt == "O-O-O" || txt == "0-0-0") {
+    int k = (txt.size() == 3) ? kingcastling : queencastling;
+    for (packedmove m : legal) {
+      if (movekindof(m) == k) {return m;}
+    }
+    return nullmove;
+  }
+
+  //type of the moving piece, pawns have no letter
+  wpiece w = generic;
+  switch (txt.front()) {
+    case 'K': w = king; break;
+    case 'Q': w = queen; break;
+    case 'R': w = rock; break;
+    case 'B': w = bishop; break;
+    case 'N': w = knight; break;
+    case 'P': w = pawn; break;
+    default: break;
+  }
+  if (w != generic) {txt.remove_prefix(1);}
+
+  //piece of the promotion, the last character is a letter only for the promotions (upper case in SAN, lower case in UCI)
+  wpiece prom = generic;
+  if (! txt.empty()) {
+    switch (txt.back()) {
+      case 'Q': case 'q': prom = queen; break;
+      case 'R': case 'r': prom = rock; break;
+      case 'B': case 'b': prom = bishop; break;
+      case 'N': case 'n': prom = knight; break;
+      default: break;
+    }
+    if (prom != generic) {
+      txt.remove_suffix(1);
+      if (! txt.empty() && txt.back() == '=') {txt.remove_suffix(1);}
+    }
+  }
+
+  //arrival square, the last two characters
+  if (txt.size() < 2) {return nullmove;}
+  char tf = txt[txt.size() -2];
+  char tr = txt[txt.size() -1];
+  if (tf < 'a' || tf >= 'a' + MAXX || tr < '1' || tr >= '1' + MAXY) {return nullmove;}
+  int to = sqindex(tf - 'a', MAXY - (tr - '0'));
+  txt.remove_suffix(2);
+
+  //column and / or row of the starting square, the signs of eating and of long notation are skipped
+  int fromx = -1;
+  int fromy = -1;
+  for (char ch : txt) {
+    if (ch >= 'a' && ch < 'a' + MAXX) {fromx = ch - 'a';}
+    else if (ch >= '1' && ch < '1' + MAXY) {fromy = MAXY - (ch - '0');}
+    else if (ch != 'x' && ch != '-' && ch != ':') {return nullmove;}
+  }
+  if (w == generic && (fromx == -1 || fromy == -1)) {w = pawn;} //in UCI notation the starting square is complete and the piece is not given
+  if (prom == generic) {prom = queen;}
+
+  packedmove found = nullmove;
+  for (packedmove m : legal) {
+    int from = movefrom(m);
+    if (moveto(m) != to) {continue;}
+    if (fromx != -1 && sqfile(from) != fromx) {continue;}
+    if (fromy != -1 && sqrow(from) != fromy) {continue;}
+    if (w != generic && typeat(from) != w) {continue;}
+    if (ispromotion(m) && promotedpiece(m) != prom) {continue;}
+    if (found != nullmove) {return nullmove;} //ambiguous text
+    found = m;
+  }
+  return found;
+}
+
+//write the notation of a legal move of the player who moves in buf (at least notationsize chars), in short algebraic notation (SAN)
+//or in the long one (LAN, starting and arrival squares as used by the saving files and the UCI history). Get the number of written chars.
+int ChessBitboard::writemove(packedmove m, char* buf, bool longnot) const {
+  const char letters[7] = {'0', 'P', 'R', 'N', 'B', 'Q', 'K'}; //indexed by wpiece
+  int from = movefrom(m);
+  int to = moveto(m);
+  int k = movekindof(m);
+  wpiece w = typeat(from);
+  int n = 0;
+
+  if (longnot) {
+    buf[n++] = 'a' + sqfile(from);
+    buf[n++] = '0' + MAXY - sqrow(from);
+    buf[n++] = iseatmove(m) ? 'x' : '-';
+  } else if (k == kingcastling || k == queencastling) {
+    const char* cst = (k == kingcastling) ? "O-O" : "O-O-O";
+    while (*cst) {buf[n++] = *cst++;}
+  } else if (w == pawn) {
+    if (iseatmove(m)) {buf[n++] = 'a' + sqfile(from); buf[n++] = 'x';}
+  } else {
+    buf[n++] = letters[w];
+
+    //the coordinates of the starting square needed to tell apart the other pieces of the same type which can legally move in the arrival square
+    MoveList legal;
+    generate_legal(legal);
+    bool others = false, samefile = false, samerow = false;
+    for (packedmove alt : legal) {
+      int altsq = movefrom(alt);
+      if (moveto(alt) != to || altsq == from || typeat(altsq) != w) {continue;}
+      others = true;
+      if (sqfile(altsq) == sqfile(from)) {samefile = true;}
+      if (sqrow(altsq) == sqrow(from)) {samerow = true;}
+    }
+    if (others && (! samefile || samerow)) {buf[n++] = 'a' + sqfile(from);}
+    if (others && samefile) {buf[n++] = '0' + MAXY - sqrow(from);}
+    if (iseatmove(m)) {buf[n++] = 'x';}
+  }
+
+  if (longnot || (k != kingcastling && k != queencastling)) {
+    buf[n++] = 'a' + sqfile(to);
+    buf[n++] = '0' + MAXY - sqrow(to);
+  }
+  if (ispromotion(m)) {buf[n++] = '='; buf[n++] = letters[promotedpiece(m)];}
+
+  //symbols of check and checkmate, the move is tried on a copy of the position
+  ChessBitboard after = *this;
+  ChessUndo undo;
+  after.make_move(m, undo);
+  if (after.incheck(after.side)) {buf[n++] = after.ischeckmate() ? '#' : '+';}
+
+  buf[n] = '\0';
+  return n;
+}
+
+//write a move in UCI notation (starting and arrival squares, then the promoted piece in lower case), no position is needed. Get the number of written chars.
+int ChessBitboard::writeuci(packedmove m, char* buf) {
+  const char letters[7] = {'0', 'p', 'r', 'n', 'b', 'q', 'k'}; //indexed by wpiece
+  int n = 0;
+  buf[n++] = 'a' + sqfile(movefrom(m));
+  buf[n++] = '0' + MAXY - sqrow(movefrom(m));
+  buf[n++] = 'a' + sqfile(moveto(m));
+  buf[n++] = '0' + MAXY - sqrow(moveto(m));
+  if (ispromotion(m)) {buf[n++] = letters[promotedpiece(m)];}
+  buf[n] = '\0';
+  return n;
+}
+
+/* Tables of the FEN letters of the pieces. fenpieces gives for each char the type of piece in the lowest 3 bits
+ * and 8 for the white pieces, 0 if the char is not a piece. fenletters gives the letter of each piece, indexed by color and type.
+ */
+const char fenletters[2][7] = {{'0', 'p', 'r', 'n', 'b', 'q', 'k'}, {'0', 'P', 'R', 'N', 'B', 'Q', 'K'}};
+
+constexpr std::array<std::uint8_t, 128> makefenpieces() {
+  std::array<std::uint8_t, 128> t{};
+  for (int w = pawn; w <= king; w++) {
+    t[static_cast<unsigned char>(fenletters[black][w])] = w;
+    t[static_cast<unsigned char>(fenletters[white][w])] = w | 8;
+  }
+  return t;
+}
+constexpr std::array<std::uint8_t, 128> fenpieces = makefenpieces();
+
+//read a non negative number at the beginning of txt, removing it from txt. Get -1 if txt does not start with a digit
+static int readfennumber(std::string_view& txt) {
+  if (txt.empty() || txt.front() < '0' || txt.front() > '9') {return -1;}
+  int res = 0;
+  while (! txt.empty() && txt.front() >= '0' && txt.front() <= '9' && res < 100000) {
+    res = res * 10 + (txt.front() - '0');
+    txt.remove_prefix(1);
+  }
+  return res;
+}
+
+//write a non negative number in buf, get the number of written chars
+static int writefennumber(int num, char* buf) {
+  char digits[12];
+  int nd = 0;
+  do {digits[nd++] = '0' + num % 10; num /= 10;} while (num > 0 && nd < 11);
+  for (int i = 0; i < nd; i++) {buf[i] = digits[nd -1 -i];}
+  return nd;
+}
+
+//skip the operations of an EPD record (an opcode and its operands, up to a semicolon not in a string), get false if one is not complete
+static bool skipepdoperations(std::string_view& txt) {
+  while (! txt.empty()) {
+    if (! std::isalpha(static_cast<unsigned char>(txt.front()))) {return false;}
+    bool instring = false;
+    while (! txt.empty() && (instring || txt.front() != ';')) {
+      if (txt.front() == '"') {instring = ! instring;}
+      txt.remove_prefix(1);
+    }
+    if (txt.empty()) {return false;}
+    txt.remove_prefix(1);
+    while (! txt.empty() && txt.front() == ' ') {txt.remove_prefix(1);}
+  }
+  return true;
+}
+
+//set the position written in FEN notation (Forsyth-Edwards Notation), get false if the text is not valid.
+//The board and the player who moves are required, castling, en passant and the counters can be omitted. The operations of EPD records are accepted in place of the counters.
+bool ChessBitboard::readfen(std::string_view fen) {
+  clear();
+  while (! fen.empty() && fen.front() == ' ') {fen.remove_prefix(1);}
+
+  //pieces on the chessboard, from the 8th row
+  int x = 0, y = 0;
+  while (! fen.empty() && fen.front() != ' ') {
+    unsigned char ch = fen.front();
+    fen.remove_prefix(1);
+    if (ch == '/') {
+      if (x != MAXX || y == MAXY -1) {return false;}
+      x = 0;
+      y++;
+    } else if (ch >= '1' && ch < '1' + MAXX) {
+      x += ch - '0';
+      if (x > MAXX) {return false;}
+    } else {
+      std::uint8_t code = (ch < 128) ? fenpieces[ch] : 0;
+      if (code == 0 || x >= MAXX) {return false;}
+      putpiece(static_cast<wpiece>(code & 7), (code & 8) ? white : black, sqindex(x, y));
+      x++;
+    }
+  }
+  if (x != MAXX || y != MAXY -1) {return false;}
+  if (bbcount(pieces(white, king)) != 1 || bbcount(pieces(black, king)) != 1) {return false;}
+  const bitboard lastrows = (sqbit(MAXX) - 1) | ((sqbit(MAXX) - 1) << sqindex(MINX, MAXY -1));
+  if (bytype[pawn] & lastrows) {return false;} //the pawns cannot stay in the first and last rows, the moves from there would leave the board
+
+  //player who moves
+  while (! fen.empty() && fen.front() == ' ') {fen.remove_prefix(1);}
+  if (fen.empty() || (fen.front() != 'w' && fen.front() != 'b')) {return false;}
+  side = (fen.front() == 'w') ? white : black;
+  fen.remove_prefix(1);
+
+  //castling possibilities, kept only if the king and the rock are in their starting squares
+  while (! fen.empty() && fen.front() == ' ') {fen.remove_prefix(1);}
+  while (! fen.empty() && fen.front() != ' ') {
+    switch (fen.front()) {
+      case 'K': castling |= whkingside; break;
+      case 'Q': castling |= whqueenside; break;
+      case 'k': castling |= blkingside; break;
+      case 'q': castling |= blqueenside; break;
+      case '-': break;
+      default: return false;
+    }
+    fen.remove_prefix(1);
+  }
+  const int cornersq[4] = {sqindex(MAXX -1, MAXY -1), sqindex(MINX, MAXY -1), sqindex(MAXX -1, MINY), sqindex(MINX, MINY)};
+  for (int r = 0; r < 4; r++) {
+    c_color c = (r < 2) ? white : black;
+    int kingsq = sqindex(4, (c == white) ? MAXY -1 : MINY);
+    if (! (pieces(c, king) & sqbit(kingsq)) || ! (pieces(c, rock) & sqbit(cornersq[r]))) {castling &= ~(1 << r);}
+  }
+
+  //en passant square, kept only if behind a pawn which has just done the double step
+  while (! fen.empty() && fen.front() == ' ') {fen.remove_prefix(1);}
+  if (! fen.empty() && fen.front() != '-') {
+    if (fen.size() < 2 || fen[0] < 'a' || fen[0] >= 'a' + MAXX || fen[1] < '1' || fen[1] >= '1' + MAXY) {return false;}
+    int ep = sqindex(fen[0] - 'a', MAXY - (fen[1] - '0'));
+    int pushed = (side == white) ? ep + MAXX : ep - MAXX;
+    if (sqrow(ep) == ((side == white) ? 2 : MAXY -3) && (pieces(!side, pawn) & sqbit(pushed)) && ! (occupied() & sqbit(ep))) {epsquare = ep;}
+    fen.remove_prefix(2);
+  } else if (! fen.empty()) {fen.remove_prefix(1);}
+  if (! fen.empty() && fen.front() != ' ') {return false;}
+
+  //halfmove counter and turn of a FEN text, nothing can follow them. Otherwise the operations of an EPD record, which are skipped
+  while (! fen.empty() && fen.front() == ' ') {fen.remove_prefix(1);}
+  if (! fen.empty() && fen.front() >= '0' && fen.front() <= '9') {
+    halfmove = readfennumber(fen);
+    while (! fen.empty() && fen.front() == ' ') {fen.remove_prefix(1);}
+    int num = readfennumber(fen);
+    if (num > 0) {fullmove = num;}
+    while (! fen.empty() && fen.front() == ' ') {fen.remove_prefix(1);}
+    if (! fen.empty()) {return false;}
+  } else if (! skipepdoperations(fen)) {return false;}
+
+  if (incheck(!side)) {return false;} //the king of the player who has just moved cannot be left in check
+  computekey();
+  return true;
+}
+
+//write the position in FEN notation in buf (at least fensize chars), get the number of written chars
+int ChessBitboard::writefen(char* buf) const {
+  int n = 0;
+  for (int y = MINY; y < MAXY; y++) {
+    int empty = 0;
+    for (int x = MINX; x < MAXX; x++) {
+      int sq = sqindex(x, y);
+      if (! (occupied() & sqbit(sq))) {empty++; continue;}
+      if (empty > 0) {buf[n++] = '0' + empty; empty = 0;}
+      buf[n++] = fenletters[colorat(sq)][typeat(sq)];
+    }
+    if (empty > 0) {buf[n++] = '0' + empty;}
+    if (y != MAXY -1) {buf[n++] = '/';}
+  }
+
+  buf[n++] = ' ';
+  buf[n++] = (side == white) ? 'w' : 'b';
+  buf[n++] = ' ';
+  if (castling == 0) {buf[n++] = '-';}
+  if (castling & whkingside) {buf[n++] = 'K';}
+  if (castling & whqueenside) {buf[n++] = 'Q';}
+  if (castling & blkingside) {buf[n++] = 'k';}
+  if (castling & blqueenside) {buf[n++] = 'q';}
+  buf[n++] = ' ';
+  if (epsquare == -1) {buf[n++] = '-';}
+  else {
+    buf[n++] = 'a' + sqfile(epsquare);
+    buf[n++] = '0' + MAXY - sqrow(epsquare);
+  }
+  buf[n++] = ' ';
+  n += writefennumber(halfmove, buf + n);
+  buf[n++] = ' ';
+  n += writefennumber(fullmove, buf + n);
+  buf[n] = '\0';
+  return n;
+}
+
+//read n FEN texts into the positions pos, get the number of valid texts. The positions of the invalid texts are left empty (without kings)
+std::size_t ChessBitboard::readfens(const std::string_view* fens, std::size_t n, ChessBitboard* pos) {
+  std::size_t nvalid = 0;
+  for (std::size_t i = 0; i < n; i++) {
+    if (pos[i].readfen(fens[i])) {nvalid++;}
+    else {pos[i].clear();}
+  }
+  return nvalid;
+}
+
+//write n positions in FEN notation in buf, one after the other every fensize chars (buf must have n * fensize chars)
+void ChessBitboard::writefens(const ChessBitboard* pos, std::size_t n, char* buf) {
+  for (std::size_t i = 0; i < n; i++) {pos[i].writefen(buf + i * fensize);}
+}
+
+//count the leaves of the tree of the legal moves of the given depth, the moves of the last level are counted without being done
+std::uint64_t ChessBitboard::perft(int depth) {
+  if (depth <= 0) {return 1;}
+
+  MoveList legal;
+  generate_legal(legal);
+  if (depth == 1) {return legal.size();}
+
+  std::uint64_t nodes = 0;
+  ChessUndo undo;
+  for (packedmove m : legal) {
+    make_move(m, undo);
+    nodes += perft(depth - 1);
+    unmake_move(m, undo);
+  }
+  return nodes;
+}
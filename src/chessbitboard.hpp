@@ -0,0 +1,347 @@
+/*
+ * chessbitboard.hpp
+ * 
+ * Copyright 2017 Valentino Esposito <valentinoe85@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+
+#ifndef CHESSBITBOARD_H_DEF
+#define CHESSBITBOARD_H_DEF 1
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "chess_dconst.hpp"
+
+/* A bitboard is a set of squares, one bit for each square of the chessboard.
+ * Squares are indexed as y * MAXX + x, using the same coordinates of the ChessBoard squares matrix:
+ * index 0 is a8, index 7 is h8, index 63 is h1.
+ */
+typedef std::uint64_t bitboard;
+
+//quick functions to convert between coordinates and square indexes, usable at compile time
+constexpr int sqindex(int x, int y) {return y * MAXX + x;}
+constexpr int sqfile(int sq) {return sq % MAXX;}
+constexpr int sqrow(int sq) {return sq / MAXX;}
+constexpr bitboard sqbit(int sq) {return bitboard(1) << sq;}
+constexpr bool sqonboard(int x, int y) {return x >= MINX && x < MAXX && y >= MINY && y < MAXY;}
+
+//the light squares of the chessboard (a8 is light), used to tell the color of the squares of the bishops
+constexpr bitboard makelightsquares() {
+  bitboard res = 0;
+  for (int sq = 0; sq < MAXX * MAXY; sq++) {
+    if ((sqfile(sq) + sqrow(sq)) % 2 == 0) {res |= sqbit(sq);}
+  }
+  return res;
+}
+constexpr bitboard lightsquares = makelightsquares();
+
+/* The material key is the signature of the pieces on the chessboard: the number of pieces of each type and color,
+ * packed in 4 bits each (enough for promotions), at bit 4 * (8 * color + type). Positions with the same pieces,
+ * whatever their squares, have the same key: it selects endgames and can be used for queries on the material.
+ */
+typedef std::uint64_t materialkey;
+
+constexpr int materialshift(wpiece w, c_color c) {return 4 * (8 * c + w);}
+constexpr materialkey materialunit(wpiece w, c_color c) {return materialkey(1) << materialshift(w, c);}
+constexpr int materialcount(materialkey mk, wpiece w, c_color c) {return (mk >> materialshift(w, c)) & 0xF;}
+
+//quick functions to handle the set bits of a bitboard
+inline int bbcount(bitboard b) {return __builtin_popcountll(b);}
+inline int bbfirst(bitboard b) {return __builtin_ctzll(b);}
+inline int bbpopfirst(bitboard& b) {int sq = __builtin_ctzll(b); b &= b - 1; return sq;}
+
+/* Moves are packed in 16 bits: the starting square in the lowest 6 bits, the arrival square in the next 6 bits
+ * and the kind of move in the highest 4 bits. In the kind, the bit 4 marks the eatings and the bit 8 marks the promotions.
+ */
+typedef std::uint16_t packedmove;
+enum movekind {quietmove, doublepush, kingcastling, queencastling, eatmove, enpassant,
+               promoknight = 8, promobishop, promorock, promoqueen, promoknighteat, promobishopeat, promorockeat, promoqueeneat};
+
+//quick functions to pack and unpack the moves
+const int fensize = 128; //size of the buffers for the FEN notation of a position, enough for the longest one
+const int notationsize = 16; //size of the buffers for the notation of a move, enough for the longest one
+const std::string_view startfen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"; //FEN notation of the initial position
+const packedmove nullmove = 0; //never a legal move (same starting and arrival square), returned when a move is not found
+
+inline packedmove packmove(int from, int to, int k) {return static_cast<packedmove>(from | (to << 6) | (k << 12));}
+inline int movefrom(packedmove m) {return m & 0x3F;}
+inline int moveto(packedmove m) {return (m >> 6) & 0x3F;}
+inline int movekindof(packedmove m) {return m >> 12;}
+inline bool iseatmove(packedmove m) {return (m >> 12) & eatmove;}
+inline bool ispromotion(packedmove m) {return (m >> 12) & promoknight;}
+inline wpiece promotedpiece(packedmove m) {
+  const wpiece prom[4] = {knight, bishop, rock, queen};
+  return prom[(m >> 12) & 3];
+}
+
+//castling possibilities, as bits of ChessBitboard::castling
+enum castlingright {whkingside = 1, whqueenside = 2, blkingside = 4, blqueenside = 8};
+
+/* Geometry of the pieces as (x, y) steps on the chessboard, selected at compile time by type of piece and color.
+ * Knights, kings and pawns (eating) do a single step, rocks and bishops repeat each step along a ray, the queen has both rays.
+ */
+template <wpiece W, c_color C = white> struct ChessGeometry;
+
+template <> struct ChessGeometry<knight> {
+  static constexpr int nsteps = 8;
+  static constexpr int steps[nsteps][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+};
+
+template <> struct ChessGeometry<king> {
+  static constexpr int nsteps = 8;
+  static constexpr int steps[nsteps][2] = {{0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}};
+};
+
+template <> struct ChessGeometry<pawn, white> {
+  static constexpr int nsteps = 2;
+  static constexpr int steps[nsteps][2] = {{1, -1}, {-1, -1}}; //white pawns move toward y = 0
+};
+
+template <> struct ChessGeometry<pawn, black> {
+  static constexpr int nsteps = 2;
+  static constexpr int steps[nsteps][2] = {{1, 1}, {-1, 1}};
+};
+
+template <> struct ChessGeometry<rock> {
+  static constexpr int nsteps = 4;
+  static constexpr int steps[nsteps][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+};
+
+template <> struct ChessGeometry<bishop> {
+  static constexpr int nsteps = 4;
+  static constexpr int steps[nsteps][2] = {{1, 1}, {1, -1}, {-1, -1}, {-1, 1}};
+};
+
+//squares reached from each square by a single step of a piece
+struct ChessStepTable {
+  bitboard reach[MAXX * MAXY];
+};
+
+//build the step table of a piece, it is evaluated by the compiler
+template <wpiece W, c_color C = white> constexpr ChessStepTable makesteptable() {
+  ChessStepTable t = {};
+  for (int sq = 0; sq < MAXX * MAXY; sq++) {
+    for (int i = 0; i < ChessGeometry<W, C>::nsteps; i++) {
+      int x = sqfile(sq) + ChessGeometry<W, C>::steps[i][0];
+      int y = sqrow(sq) + ChessGeometry<W, C>::steps[i][1];
+      if (sqonboard(x, y)) {t.reach[sq] |= sqbit(sqindex(x, y));}
+    }
+  }
+  return t;
+}
+
+//squares reached by a sliding piece along its rays, each ray stops at the first occupied square (which is included)
+template <wpiece W> constexpr bitboard rayattacks(int sq, bitboard occ) {
+  bitboard res = 0;
+  for (int i = 0; i < ChessGeometry<W>::nsteps; i++) {
+    int x = sqfile(sq) + ChessGeometry<W>::steps[i][0];
+    int y = sqrow(sq) + ChessGeometry<W>::steps[i][1];
+    while (sqonboard(x, y)) {
+      res |= sqbit(sqindex(x, y));
+      if (occ & sqbit(sqindex(x, y))) {break;}
+      x += ChessGeometry<W>::steps[i][0];
+      y += ChessGeometry<W>::steps[i][1];
+    }
+  }
+  return res;
+}
+
+/* List of moves with a fixed capacity, it can live on the stack and never allocates memory.
+ * No legal position has more than 218 moves, 256 is a safe bound.
+ */
+class MoveList {
+  private:
+    std::array<packedmove, 256> moves;
+    unsigned int nmoves = 0;
+
+  public:
+    void clear(void) {nmoves = 0;}
+    void add(packedmove m) {moves[nmoves++] = m;}
+    unsigned int size(void) const {return nmoves;}
+    packedmove operator[] (unsigned int i) const {return moves[i];}
+    const packedmove* begin(void) const {return moves.data();}
+    const packedmove* end(void) const {return moves.data() + nmoves;}
+};
+
+/* Struct holding what is needed to look up the attacks of a sliding piece from a square:
+ * the mask of the squares whose occupancy matters, the magic multiplier and the position of the square in the attack table.
+ * When the BMI2 instruction set is available the index is extracted by PEXT and the magic multiplier is not used.
+ */
+struct ChessMagic {
+  bitboard mask;
+  bitboard magic;
+  unsigned int shift;
+  unsigned int offset;
+
+  unsigned int index(bitboard) const;
+};
+
+/* Struct holding what is lost when a move is done and is needed to undo it
+ */
+struct ChessUndo {
+  wpiece eated; //the eated piece, generic if no piece is eated
+  int castling; //castling possibilities before the move
+  int epsquare; //en passant square before the move
+  int halfmove; //halfmove counter before the move
+  std::uint64_t key; //hash key before the move
+  materialkey material; //material key before the move
+};
+
+/* Struct holding the checks and the pins against the king of a player, computed once per position by ChessBitboard::checkinfo.
+ * A move of a piece other than the king is legal if it reaches a square of evasions and, when the piece is pinned,
+ * if it stays on the line joining the piece and the king.
+ */
+struct ChessCheckInfo {
+  int kingsq; //square of the king, -1 if the king is not on the chessboard
+  bitboard checkers; //pieces of the opponent giving check
+  bitboard evasions; //squares answering the check: all with no check, the checker and the squares in between with a single check, none with a double check
+  bitboard pinned; //pieces of the player which cannot leave the line between the king and a sliding piece of the opponent
+  bitboard kingescapes; //squares where the king can step without being in check
+};
+
+/* Squares eatable by the pieces of a color, with the set of the pieces eating in each square.
+ * It is filled by ChessBitboard::fillattackmap and holds as long as the disposition of the pieces does not change.
+ */
+struct ChessAttackMap {
+  bool ready = false; //false until the map is filled
+  std::uint64_t key = 0; //hash key of the position the map was filled for
+  bitboard attacked; //all the squares where a piece can eat
+  std::array<bitboard, MAXX * MAXY> attackers; //pieces eating in each square
+};
+
+/* Class holding the disposition of the pieces as bitboards, one for each color and one for each type of piece.
+ * Fake pawns are not pieces here, the en passant eating is represented by the square where the fake pawn would stay.
+ * An instance is the whole position (with the player who moves, castling, en passant and counters): it is a small
+ * trivially copyable value, so that a position can be saved or forked with a plain copy (see ChessBoard::getposition).
+ */
+class ChessBitboard {
+  private:
+    std::array<bitboard, 2> bycolor; //indexed by c_color
+    std::array<bitboard, 7> bytype; //indexed by wpiece, generic is not used
+
+    //attack tables of the pieces doing a single step, built at compile time
+    static constexpr ChessStepTable knighttable = makesteptable<knight>();
+    static constexpr ChessStepTable kingtable = makesteptable<king>();
+    static constexpr ChessStepTable pawntable[2] = {makesteptable<pawn, black>(), makesteptable<pawn, white>()}; //indexed by c_color
+
+    //attack tables of the sliding pieces, too large to be built by the compiler: they are built by inittables when the first board is constructed
+    static std::array<ChessMagic, MAXX * MAXY> rockmagics;
+    static std::array<ChessMagic, MAXX * MAXY> bishopmagics;
+    static std::array<bitboard, 102400> rocktable; //all the occupancy subsets of all the squares for the rocks
+    static std::array<bitboard, 5248> bishoptable; //the same for the bishops
+    static std::array<std::array<bitboard, MAXX * MAXY>, MAXX * MAXY> betweentable; //squares between two squares on the same row, column or diagonal
+    static std::array<std::array<bitboard, MAXX * MAXY>, MAXX * MAXY> linetable; //whole row, column or diagonal through two squares, 0 if not aligned
+
+    //random numbers for the Zobrist hash key, one for each piece in each square, castling possibilities, en passant column and player who moves
+    static std::array<std::array<std::array<std::uint64_t, MAXX * MAXY>, 7>, 2> zpieces;
+    static std::array<std::uint64_t, 16> zcastling;
+    static std::array<std::uint64_t, MAXX> zepfile;
+    static std::uint64_t zside;
+
+    std::uint64_t key = 0; //Zobrist hash key of the position, updated by make_move
+    materialkey material = 0; //material key of the position, updated by make_move only on eatings and promotions
+
+    template <wpiece W> static void initsliders(std::array<ChessMagic, MAXX * MAXY>&, bitboard*, const std::array<bitboard, MAXX * MAXY>&);
+    static bool inittables(void);
+    static void readytables(void) {static const bool ready = inittables(); (void) ready;} //builds the tables on first use, also from static constructors of other files
+
+    void toggle(wpiece w, c_color c, int sq) {bycolor[c] ^= sqbit(sq); bytype[w] ^= sqbit(sq); key ^= zpieces[c][w][sq];} //add or remove a piece
+    std::uint64_t epkey(void) const;
+    void addpawnmoves(MoveList&, int, int, bool) const;
+    template <wpiece W> void addpiecemoves(MoveList&, bitboard, bitboard) const;
+    template <wpiece W> void spreadattacks(c_color, bitboard, ChessAttackMap&) const;
+    void generate_pseudo(MoveList&) const;
+    bool islegal(packedmove, const ChessCheckInfo&) const;
+    template <wpiece W> bool canmove(bitboard, const ChessCheckInfo&) const;
+    bool has_legal_move(const ChessCheckInfo&) const;
+
+  public:
+    int epsquare = -1; //square of the fake pawn, -1 if no en passant eating is possible
+    c_color side = white; //the player who moves
+    int castling = 0; //castling possibilities, combination of castlingright bits
+    int halfmove = 0; //number of halfmoves since the last pawn move or eating
+    int fullmove = 1; //number of the turn, incremented after each move of black
+
+    ChessBitboard();
+
+    void clear(void);
+    void putpiece(wpiece, c_color, int);
+    void computekey(void);
+    std::uint64_t hashkey(void) const {return key;}
+    materialkey matkey(void) const {return material;}
+    bool insufficientmaterial(void) const;
+
+    bitboard occupied(void) const {return bycolor[black] | bycolor[white];}
+    bitboard pieces(c_color c) const {return bycolor[c];}
+    bitboard pieces(c_color c, wpiece w) const {return bycolor[c] & bytype[w];}
+    wpiece typeat(int) const;
+    c_color colorat(int sq) const {return (bycolor[white] & sqbit(sq)) ? white : black;}
+    int kingsquare(c_color) const;
+
+    static bitboard pawnattacks(c_color c, int sq) {return pawntable[c].reach[sq];}
+    static bitboard knightattacks(int sq) {return knighttable.reach[sq];}
+    static bitboard kingattacks(int sq) {return kingtable.reach[sq];}
+    static bitboard bishopattacks(int, bitboard);
+    static bitboard rockattacks(int, bitboard);
+    static bitboard queenattacks(int sq, bitboard occ) {return bishopattacks(sq, occ) | rockattacks(sq, occ);}
+    template <wpiece W> static bitboard attacks(int, bitboard); //eating squares of the pieces other than pawns, selected at compile time
+
+    bitboard attackers(int, c_color, bitboard) const;
+    bitboard attackers(int sq, c_color c) const {return attackers(sq, c, occupied());}
+    bitboard menacers(int sq, c_color c, int selmet) const {return menacers(sq, c, selmet, attackers(sq, c));}
+    bitboard menacers(int, c_color, int, bitboard) const;
+    void fillattackmap(c_color, ChessAttackMap&) const;
+    bitboard actions(wpiece, c_color, int, int) const;
+    bool isattacked(int sq, c_color c) const {return attackers(sq, c) != 0;}
+    bool incheck(c_color) const;
+    ChessCheckInfo checkinfo(c_color) const;
+    bool ischeckmate(void) const;
+    bool isstalemate(void) const;
+    bool has_legal_move(void) const {return has_legal_move(checkinfo(side));}
+
+    packedmove buildmove(int, int, wpiece = queen) const;
+    void make_move(packedmove, ChessUndo&);
+    void unmake_move(packedmove, const ChessUndo&);
+    void generate_legal(MoveList&) const;
+    bool islegal(packedmove) const;
+    packedmove parsemove(std::string_view) const;
+    int writemove(packedmove, char*, bool = false) const;
+    static int writeuci(packedmove, char*);
+
+    bool readfen(std::string_view);
+    int writefen(char*) const;
+    static std::size_t readfens(const std::string_view*, std::size_t, ChessBitboard*); //batch conversions, for many positions at once
+    static void writefens(const ChessBitboard*, std::size_t, char*);
+    std::uint64_t perft(int);
+};
+
+template <> inline bitboard ChessBitboard::attacks<rock>(int sq, bitboard occ) {return rockattacks(sq, occ);}
+template <> inline bitboard ChessBitboard::attacks<knight>(int sq, bitboard) {return knightattacks(sq);}
+template <> inline bitboard ChessBitboard::attacks<bishop>(int sq, bitboard occ) {return bishopattacks(sq, occ);}
+template <> inline bitboard ChessBitboard::attacks<queen>(int sq, bitboard occ) {return queenattacks(sq, occ);}
+template <> inline bitboard ChessBitboard::attacks<king>(int sq, bitboard) {return kingattacks(sq);}
+
+static_assert(std::is_trivially_copyable<ChessBitboard>::value, "ChessBitboard must be copyable with memcpy");
+static_assert(sizeof(ChessBitboard) <= 128, "ChessBitboard must be a small value");
+
+#endif
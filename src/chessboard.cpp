@@ -23,271 +23,370 @@
 
 
 #include <algorithm> //for std::find function
-#include <unistd.h> //for sleep function
+#include <unistd.h> //for sleep and close functions
+#include <fcntl.h> //for open function
+#include <cerrno> //for errno
 #include <chrono> //for typedef time_t, localtime function, system_clock class
+#include <cstdio> //for snprintf function
+#include <cstring> //for memcpy function
+#include <sys/mman.h> //for mmap function
+#include <sys/stat.h> //for fstat function
 
 #include "chessboard.hpp"
 
 /* ChessExts initialization
  */
 //std::string ChessExts::saveext = ".gchess"; //extension for files to saving the game, native format
-std::string ChessExts::saveext = ".pgn"; //extension for files to saving the game, using the standard PGN format
-std::string ChessExts::histext = ".hchess"; //extension for text files to write the history of the game in algebraic notation
+const std::string ChessExts::saveext = ".pgn"; //extension for files to saving the game, using the standard PGN format
+const std::string ChessExts::histext = ".hchess"; //extension for text files to write the history of the game in algebraic notation
+
+/* ChessRecoveryWriter methods
+ */
+//the writer takes the file descriptor of the recovery file, which is closed at the end
+ChessRecoveryWriter::ChessRecoveryWriter(int f, std::string fn, std::chrono::milliseconds w) : fd(f), fname(fn), window(w) {
+  worker = std::thread(&ChessRecoveryWriter::work, this);
+}
+
+//the changes still in the queue are written and synchronized before stopping
+ChessRecoveryWriter::~ChessRecoveryWriter() {
+  {
+    std::lock_guard<std::mutex> lock(wakemutex);
+    running = false;
+  }
+  wakeup.notify_one();
+  worker.join();
+  close(fd);
+}
+
+//add a change to the queue and wake up the writer. If the queue is full (only when thousands of moves are added at once) wait for the writer
+void ChessRecoveryWriter::push(const Op& op) {
+  unsigned int t = tail.load(std::memory_order_relaxed);
+  while (t - head.load(std::memory_order_acquire) == queuesize) {std::this_thread::yield();}
+  queue[t % queuesize] = op;
+  tail.store(t + 1, std::memory_order_release);
+  {std::lock_guard<std::mutex> lock(wakemutex);} //the writer is either waiting or it has still to check the queue
+  wakeup.notify_one();
+}
+
+//start a new game from a position, given by the FEN notation
+void ChessRecoveryWriter::startgame(std::string_view f) {
+  push(Op{0, nullmove, new std::string((f == startfen) ? std::string_view() : f)});
+}
+
+/* loop of the writer thread: it sleeps until there are changes in the queue, or until the end of the window if the header
+ * is still to be written. The moves are written as soon as they arrive, the header at most once per window (group commit).
+ */
+void ChessRecoveryWriter::work() {
+  auto lastsync = std::chrono::steady_clock::now() - window;
+  auto ready = [this] {return tail.load(std::memory_order_acquire) != head.load(std::memory_order_relaxed) || ! running;};
+  std::unique_lock<std::mutex> lock(wakemutex);
+  while (true) {
+    if (headdirty) {wakeup.wait_until(lock, lastsync + window, ready);}
+    else {wakeup.wait(lock, ready);}
+    bool stop = ! running; //after the stop, the last changes are written and synchronized
+    lock.unlock();
+
+    drain();
+    writemoves();
+    auto now = std::chrono::steady_clock::now();
+    if (headdirty && (stop || now - lastsync >= window)) {
+      commit();
+      lastsync = now;
+    }
+    if (stop) {break;}
+    lock.lock();
+  }
+}
+
+//apply the changes of the queue to the copy of the game kept by the writer
+void ChessRecoveryWriter::drain() {
+  unsigned int t = tail.load(std::memory_order_acquire);
+  unsigned int h = head.load(std::memory_order_relaxed);
+  for (; h != t; h++) {
+    Op& op = queue[h % queuesize];
+    if (op.fen != nullptr) {
+      fen = *op.fen;
+      delete op.fen;
+      moves.clear();
+      fendirty = true;
+      dirtyfrom = 0;
+    } else {
+      moves.resize(op.nmoves);
+      moves[op.nmoves - 1] = op.move;
+      dirtyfrom = std::min(dirtyfrom, op.nmoves - 1);
+    }
+    headdirty = true;
+  }
+  head.store(h, std::memory_order_release);
+}
+
+//write the new moves after the ones counted by the header. If moves counted by the header change, the header is shortened (and synchronized) first
+void ChessRecoveryWriter::writemoves() {
+  bool ok = true;
+  if (fendirty || dirtyfrom < headmoves) {
+    ChessSaveHeader hd; //a new game is counted as the start position without moves, until its header is written
+    if (! fendirty) {
+      hd.nmoves = dirtyfrom;
+      hd.fenlength = fen.size();
+    }
+    ok = pwrite(fd, &hd, sizeof(ChessSaveHeader), 0) != -1 && fdatasync(fd) != -1;
+    headmoves = hd.nmoves;
+  }
+
+  off_t movepos = sizeof(ChessSaveHeader) + fen.size();
+  if (ok && fendirty) {ok = pwrite(fd, fen.data(), fen.size(), sizeof(ChessSaveHeader)) != -1;}
+  if (ok && dirtyfrom < moves.size()) {ok = pwrite(fd, moves.data() + dirtyfrom, (moves.size() - dirtyfrom) * sizeof(packedmove), movepos + dirtyfrom * sizeof(packedmove)) != -1;}
+  if (! ok) {std::cerr << "Error, the recovery file " << fname << " cannot be written!" << std::endl;}
+  fendirty = false;
+  dirtyfrom = moves.size();
+}
+
+//synchronize the written moves, then write the header counting them and synchronize it
+void ChessRecoveryWriter::commit() {
+  ChessSaveHeader hd;
+  hd.nmoves = moves.size();
+  hd.fenlength = fen.size();
+  off_t fileend = sizeof(ChessSaveHeader) + fen.size() + moves.size() * sizeof(packedmove);
+
+  bool ok = fdatasync(fd) != -1;
+  if (ok) {ok = pwrite(fd, &hd, sizeof(ChessSaveHeader), 0) != -1;}
+  if (ok) {ok = ftruncate(fd, fileend) != -1;}
+  if (ok) {ok = fdatasync(fd) != -1;}
+  if (! ok) {std::cerr << "Error, the recovery file " << fname << " cannot be synchronized!" << std::endl;}
+  headmoves = hd.nmoves;
+  headdirty = false;
+}
+
 
 /* ChessSaving methods and initialization
  */
 ChessSaving::ChessSaving() {}
 
 ChessSaving::~ChessSaving() {
-  savebuf.close();
-  //the following two lines allows to extract a C-like string from a stringstream 
-  const std::string& tmp = filename.str();
-  const char* cfn = tmp.c_str();
-  std::remove(cfn);
+  if (recwriter != nullptr) {
+    delete recwriter;
+    std::remove(recname.c_str()); //the recovery file is needed only if the program does not end properly
+  }
 }
 
-//initializing the object
-void ChessSaving::initcs(std::string fn) {
+/* set the recovery file, where the journal is written while playing by a background thread, synchronized on disk once per window.
+ * The file is created only if it does not exist (atomically), so that boards working at the same time get different files.
+ * It can be loaded with loadgame. Return false if no file can be created.
+ */
+bool ChessSaving::setrecovery(std::string fn, std::chrono::milliseconds window) {
+  if (recwriter != nullptr) {return false;}
   int n = 0;
-  bool fncheck = true;
-  filename << fn;
-  while (fncheck) {
-    if (std::ifstream(filename.str())) {
-      filename.str("");
-      filename << fn << '_' << n;
-      n++;
-    } else {fncheck = false;}
+  recname = fn;
+  int fd = open(recname.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  while (fd == -1 && errno == EEXIST) {
+    recname = fn + '_' + std::to_string(n);
+    n++;
+    fd = open(recname.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  }
+  if (fd == -1) {
+    recname = "";
+    return false;
   }
-  savebuf.open(filename.str(), std::ios::out | std::ios::in | std::ios::trunc); //needed ios::trunc here, if ios::in is provided without ios::trunc, the file is supposed to exist, no new file is created.
+  recwriter = new ChessRecoveryWriter(fd, recname, window);
+  if (records.size() > 0) {writerecovery(0);}
+  return true;
 }
 
-//chech for rule of three moves repeated for draw, better doing it here in ChessSaving rather than from the ChessBoard
-bool ChessSaving::drawforthree() {
-  bool res;
-  std::string fullcurline, opcurline, fullreferline, opreferline;
-  std::streampos lastline = linepos.back();
-  std::streampos clinep;
-  
-  //retrieving last line for reference
-  savebuf.seekg(lastline);
-  std::getline(savebuf, fullreferline);
-  opreferline = dftsetline(fullreferline);
-    
-  int eql = 0;
-  for (unsigned int i = 1; i < linepos.size(); i++) {
-    std::streampos clinep = linepos[i];
-    savebuf.seekg(clinep);
-    std::getline(savebuf, fullcurline);
-    
-    opcurline = dftsetline(fullcurline);
-    
-    if (opcurline == opreferline) {eql++;}
+//the header of the native format for the journal, the FEN notation of the initial position is written in fen (fenlength is 0 for the start position)
+ChessSaveHeader ChessSaving::makeheader(char* fen) const {
+  ChessSaveHeader hd;
+  int fenlen = keyframes.front().writefen(fen);
+  hd.fenlength = (std::string_view(fen, fenlen) == startfen) ? 0 : fenlen;
+  hd.nmoves = records.size() - 1;
+  return hd;
+}
+
+//pass to the recovery writer the moves from the given record to the end of the journal (from the initial position if 0)
+void ChessSaving::writerecovery(unsigned int from) {
+  if (from == 0) {
+    char fen[fensize];
+    int fenlen = keyframes.front().writefen(fen);
+    recwriter->startgame(std::string_view(fen, fenlen));
+    from = 1;
   }
-  
-  if (eql > 3) {res = true;}
-  else {res = false;}
-  
-  return res;
+  for (unsigned int i = from; i < records.size(); i++) {recwriter->setmove(i, records[i].move);}
 }
 
-//build a string discarding the stuff unnecessary for comparing piece disposition on the chessboard
-std::string ChessSaving::dftsetline(std::string fullline) {
-  std::string opline, res;
-  
-  std::stringstream buffull(fullline);
+//check for the rule of the position repeated three times for draw, comparing the hash keys of the positions.
+//Only the last nrev halfmoves are scanned: a position before a pawn move or an eating cannot be repeated.
+bool ChessSaving::drawforthree(int nrev) {
+  int cur = current;
+  std::uint64_t curkey = reckeys[cur];
   
-  std::getline(buffull, opline, '|'); //discarding first info on the chessboard
-  std::getline(buffull, opline, '|'); //find the player who moves
-  res = opline;
-  res.append("|");
-  std::getline(buffull, opline, '*'); //discarding last info on the chessboard
-  std::getline(buffull, opline, '*'); //discarding short algebraic notation
-  std::getline(buffull, opline, '*'); //discarding long algebraic notation
-  std::getline(buffull, opline);
+  //the player who moves is in the key, so only the positions with the same player are checked
+  int eql = 1;
+  for (int i = cur - 2; i >= 0 && i >= cur - nrev; i -= 2) {
+    if (reckeys[i] == curkey) {eql++;}
+  }
   
-  res.append(opline);
-  return res;
+  return eql >= 3;
 }
 
-//saving the current status of the game (write a single line in the autosave file)
+/* saving the current status of the game: a record is added to the journal after the current one, with the last move of the chessboard.
+ * At the beginning the journal is started again from the position of the chessboard.
+ */
 void ChessSaving::autosavegame(const ChessBoard& cbd, bool isbeginning) {
-  Piece* pp;
-  std::stringstream scc;
-  std::streampos thispos;
-  
-  clearfuture();
-  
-  thispos = savebuf.tellg();
-  linepos.push_back(thispos);
-  lineiter = linepos.end();
-  lineiter--; //to get the iterator pointing the last element, not the past-to-end element.
-  
-  if (isbeginning) {scc << cbd.players[1]->whoplay();}//is black
-  else {scc << cbd.player_moving->whoplay();}
-  
-  savebuf << cbd.turn << '|' << scc.str() << '|' << cbd.drawffcounter << "*" << cbd.algebnotshort.str() << "*" << cbd.algebnotlong.str() << "*";
-  for (unsigned int i = 0; i < cbd.pieces.size(); i++) {
-    pp = cbd.pieces[i];
-    savebuf << *pp;
+  if (isbeginning) {
+    records.clear();
+    reckeys.clear();
+    listmarks.clear();
+    for (std::string& ml : movelists) {ml.clear();}
+    keyframes.clear();
+    clocks.clear();
+    evals.clear();
+    ChessRecord rec;
+    rec.drawcounter = cbd.drawffcounter;
+    addrecord(rec, cbd.getposition(), nullptr, nullptr);
+  } else {
+    clearfuture();
+    addrecord(ChessRecord(cbd.lastpmove, cbd.lastundo, cbd.drawffcounter), cbd.bboard, cbd.algebnotshort.data(), cbd.algebnotlong.data()); //the notation was written by chessmove
   }
-  
-  savebuf << std::endl;
+  if (recwriter != nullptr) {writerecovery(current);}
 }
 
-//load game status from a line from the savefile, it returns a string with the move corresponding to the line in short algebraic notation for printing purpose
+//add a record at the end of the journal, given the position after its move and the notation of the move (not used for the first record)
+void ChessSaving::addrecord(const ChessRecord& rec, const ChessBitboard& pos, const char* shortnot, const char* longnot) {
+  if (rec.move != nullmove) {
+    //the move lists are only appended
+    char ucibuf[notationsize];
+    ChessBitboard::writeuci(rec.move, ucibuf);
+    movelists[sannot].append(shortnot).push_back(' ');
+    movelists[lannot].append(longnot).push_back(' ');
+    movelists[ucinot].append(ucibuf).push_back(' ');
+  }
+
+  records.push_back(rec);
+  reckeys.push_back(pos.hashkey());
+  current = records.size() - 1;
+  navpos = pos;
+  navrec = current;
+  if (current % keyinterval == 0) {
+    keyframes.push_back(pos);
+    listmarks.push_back({{static_cast<std::uint32_t>(movelists[sannot].size()), static_cast<std::uint32_t>(movelists[lannot].size()), static_cast<std::uint32_t>(movelists[ucinot].size())}});
+  }
+}
+
+//length of a move list up to the given record, found from the length at the previous keyframe skipping at most keyinterval moves
+std::size_t ChessSaving::listend(unsigned int n, int nt) const {
+  std::size_t len = listmarks[n / keyinterval][nt];
+  for (unsigned int i = n % keyinterval; i > 0; i--) {len = movelists[nt].find(' ', len) + 1;}
+  return len;
+}
+
+/* the position after the given record. The moves of the records are done or undone starting from the nearest known position:
+ * the last one reached or a keyframe, so that at most keyinterval / 2 moves are needed for a long jump
+ */
+ChessBitboard ChessSaving::seek(unsigned int n) {
+  unsigned int kf = n / keyinterval;
+  unsigned int dist = (navrec > n) ? navrec - n : n - navrec;
+  if (n - kf * keyinterval < dist) {
+    navpos = keyframes[kf];
+    navrec = kf * keyinterval;
+    dist = n - navrec;
+  }
+  if (kf + 1 < keyframes.size() && (kf + 1) * keyinterval - n < dist) {
+    navpos = keyframes[kf + 1];
+    navrec = (kf + 1) * keyinterval;
+  }
+
+  ChessUndo undo;
+  for (; navrec < n; navrec++) {navpos.make_move(records[navrec + 1].move, undo);}
+  for (; navrec > n; navrec--) {
+    //the material key before the move is given back by the eated piece and the promotion
+    const ChessRecord& rec = records[navrec];
+    c_color mover = !navpos.side;
+    materialkey mk = navpos.matkey();
+    if (rec.eated() != generic) {mk += materialunit(rec.eated(), navpos.side);}
+    if (ispromotion(rec.move)) {mk += materialunit(pawn, mover) - materialunit(promotedpiece(rec.move), mover);}
+    navpos.unmake_move(rec.move, rec.undo(reckeys[navrec - 1], mk));
+  }
+  return navpos;
+}
+
+//load the game status of the current record, it returns a string with the move of the record in short algebraic notation for printing purpose
 std::string ChessSaving::loadstatus(ChessBoard& chb) {
-  std::string cline, gpar, ppar, tcpar;
   std::ostringstream res;
-  savebuf.seekg(*lineiter);
-
-  std::getline(savebuf, cline);
-  std::stringstream clinebuf(cline);
+  ChessBitboard pos = seek(current);
 
-  //general parameters of the turn
-  std::getline(clinebuf, gpar, '|');
-  chb.turn = std::stoi(gpar);
-  res << gpar;
-  
-  //assigning the opposite player: the savings store the player who did the move, not the player who moves after that move
-  std::getline(clinebuf, gpar, '|');
-  if (gpar == "White") {
-    chb.player_moving = chb.players[1];
-    res << ". ";
-  } else if (gpar == "Black") {
-    chb.player_moving = chb.players[0];
-    res << "... ";
-  }
+  //the pieces are built again from the bitboards (the list is refilled in place), the counters are the ones of the chessboard when the move was done
+  chb.rebuildposition(pos);
+  chb.drawffcounter = records[current].drawcounter; //it can differ from the halfmove clock of the position, after a refused draw
   
-  //correct turn for turnlost
-  if (gpar == "Black" && turnlost) {chb.turn++;} 
-  
-  //assigning the counter for draw game
-  std::getline(clinebuf, gpar, '*');
-  chb.drawffcounter = std::stoi(gpar);
-
-  //assignign the algebraic notation strings
-  std::getline(clinebuf, gpar, '*');
-  chb.algebnotshort.str(gpar);
-  if (gpar == "---") {res.str("   ");} //to an empy line for the initial condition
-  else {res << gpar;}
-  std::getline(clinebuf, gpar, '*');
-  chb.algebnotlong.str(gpar);
-
-  //modifying the pieces
-  Piece* ptoadd, *ptoput;
-  c_color cc;
-  int nid, px, py;
-  bool ong, bmv;
-
-  //moved pieces
-  for (unsigned int k = 0; k < chb.pieces.size(); k++) {delete chb.pieces[k];}
-  chb.pieces.clear();
-  chb.whking = nullptr;
-  chb.blking = nullptr;
-  
-  while (! clinebuf.eof()) {
-    std::getline(clinebuf, ppar, '|');
-    if (ppar != "") {
-      nid = (int)(ppar[1] - '0');
-      if (ppar[2] == '0') {cc = black;} else if (ppar[2] == '1') {cc = white;}
-      ong = (bool)(ppar[3] - '0');
-      bmv = (bool)(ppar[4] - '0');
-      px = (int)(ppar[5] - '0');
-      py = (int)(ppar[6] - '0');
-      
-      if (ppar[0] == '1') {ptoadd = new ChessPawn(nid, cc, ong, bmv, px, py);}
-      else if (ppar[0] == '2') {ptoadd = new ChessRock(nid, cc, ong, bmv, px, py);}
-      else if (ppar[0] == '3') {ptoadd = new ChessKnight(nid, cc, ong, bmv, px, py);}
-      else if (ppar[0] == '4') {ptoadd = new ChessBishop(nid, cc, ong, bmv, px, py);}
-      else if (ppar[0] == '5') {ptoadd = new ChessQueen(nid, cc, ong, bmv, px, py);}
-      else if (ppar[0] == '6') {
-        ptoadd = new ChessKing(nid, cc, ong, bmv, px, py);
-        if (cc == black) {chb.blking = dynamic_cast<ChessKing*>(ptoadd);}
-        else if (cc == white) {chb.whking = dynamic_cast<ChessKing*>(ptoadd);}
-      }
-      else if (ppar[0] == '7') {ptoadd = new ChessFakePawn(nid, cc, ong, bmv, px, py);}
-      chb.pieces.push_back(ptoadd);
-    }
-  }
-  
-  //deleting all the pointers of the ChessSquare
-  for (int i = CHVector::min_x; i < CHVector::max_x; i++) {
-    for (int j =  CHVector::min_y; j < CHVector::max_y; j++) {
-      chb.emptysquare(i, j);
-    }
-  }
-  
-  //placing the reconstructed pieces on the ChessBoard
-  for (unsigned int q = 0; q < chb.pieces.size(); q++) {
-    ptoput = chb.pieces[q];
-    chb.squareinpiece(ptoput);
-  }
-  
-  //fixing the reference pawn in fakepawns (for en passant eating)
-  ChessPawn* refp;
-  ChessFakePawn *tfkp, *nfkp;
-  for (unsigned int l = 0; l < chb.pieces.size(); l++) {
-    if (chb.pieces[l]->getidtype() == fakepawn) {
-      tfkp = dynamic_cast<ChessFakePawn*>(chb.pieces[l]);
-      if (tfkp->getcolor() == white) {
-        refp = dynamic_cast<ChessPawn*>(chb.squares[tfkp->getx()][tfkp->gety()-1].p);
-      }
-      else if (tfkp->getcolor() == black) {
-        refp = dynamic_cast<ChessPawn*>(chb.squares[tfkp->getx()][tfkp->gety()+1].p);
-      }
-      nfkp = new ChessFakePawn(tfkp, refp);
-      chb.pieces[l] = nfkp;
-      chb.squareinpiece(nfkp);
-      delete tfkp;
+  if (current == 0) {
+    std::snprintf(chb.algebnotshort.data(), notationsize, "---");
+    std::snprintf(chb.algebnotlong.data(), notationsize, "---");
+    res << "   "; //to an empy line for the initial condition
+  } else {
+    //the notation of the move is taken from the move lists
+    std::array<std::array<char, notationsize>*, 2> nots = {{&chb.algebnotshort, &chb.algebnotlong}};
+    for (int nt = sannot; nt <= lannot; nt++) {
+      std::size_t start = listend(current - 1, nt);
+      std::size_t len = movelists[nt].find(' ', start) - start;
+      movelists[nt].copy(nots[nt]->data(), len, start);
+      (*nots[nt])[len] = '\0';
     }
+    if (pos.side == black) {res << pos.fullmove << ". ";} //the record stores the move, the player who did it is not the one who moves now
+    else {res << pos.fullmove - 1 << "... ";}
+    res << chb.algebnotshort.data();
   }
-  
   return res.str();
 }
 
-//delete iterator pointers of all saves of old future moves after back moves when doing a new move, return true if there is something to delete
+//delete the records of old future moves after back moves when doing a new move, return true if there is something to delete
 bool ChessSaving::clearfuture(bool onlycheck) {
   bool res = false;
-  //it makes use of some iterator algebra to verify that there are not later elements than lineiter in the linepos vector 
-  int a = lineiter - linepos.begin();
-  int b = linepos.end() - linepos.begin() - 1;
-  if (a != b && b != -1) {
+  if (current + 1 < records.size()) {
     res = true;
-    if (! onlycheck) {linepos.erase(a + linepos.begin()+1, linepos.end());}
+    if (! onlycheck) {
+      records.erase(records.begin() + current + 1, records.end());
+      reckeys.erase(reckeys.begin() + current + 1, reckeys.end());
+      for (unsigned int k = 0; k < movelists.size(); k++) {movelists[k].resize(listend(current, k));}
+      keyframes.resize(current / keyinterval + 1);
+      listmarks.resize(current / keyinterval + 1);
+      if (clocks.size() > current + 1) {clocks.resize(current + 1);}
+      if (evals.size() > current + 1) {evals.resize(current + 1);}
+      if (navrec > current) {
+        navpos = keyframes.back();
+        navrec = (keyframes.size() - 1) * keyinterval;
+      }
+    }
   }
   return res;
 }
 
-//extract history of the game in algebraic notation from the saving file
+//extract history of the game in algebraic notation from the move lists
 std::string ChessSaving::gethistory(bool aligned, bool getlong, bool plain) {
-  std::string curline, cpar;
+  notation nt = getlong ? lannot : sannot;
+  if (plain) {return movelists[nt];}
+
   std::stringstream res;
-  
   std::string delimiter;
   if (aligned) {delimiter = "\n";}
   else {delimiter = " ";}
   
-  for (unsigned int i = 1; i < linepos.size(); i++) {//from 1 to discard the first line correspondind to the initial disposition of the pieces
-    std::streampos clinep = linepos[i];
-    savebuf.seekg(clinep);
-    std::getline(savebuf, curline);
-    
-    std::stringstream clinebuf(curline);
-    
-    std::getline(clinebuf, cpar, '*'); //this is to discard whatever is before the first *
-    std::getline(clinebuf, cpar, '*'); //this is to get only what is up to the second *. Now gpar contains the short algebraic notation of the move
-    if (getlong) {std::getline(clinebuf, cpar, '*');} //if this is done, cpar contains the long algebraic notation of the move
-    
-    if (plain) {res << cpar << " ";}
-    else {
-      if (i % 2 == 0) {res << " " << cpar << delimiter;}
-      else {res << (i+1)/2 << ". " << cpar;}
-    }
+  std::size_t start = 0;
+  for (unsigned int i = 1; i < records.size(); i++) {//from 1 to discard the first record corresponding to the initial disposition of the pieces
+    std::size_t end = movelists[nt].find(' ', start);
+    std::string_view cpar(movelists[nt].data() + start, end - start);
+    start = end + 1;
+    if (i % 2 == 0) {res << " " << cpar << delimiter;}
+    else {res << (i+1)/2 << ". " << cpar;}
   }
   
   return res.str();
 }
 
+//get the moves up to the current record in the given notation, separated by spaces (without a space at the end)
+std::string_view ChessSaving::getmoves(notation nt) const {
+  std::size_t len = listend(current, nt);
+  return std::string_view(movelists[nt].data(), (len > 0) ? len - 1 : 0);
+}
+
 //write history of the game in a txt file
 void ChessSaving::writefhist(std::string hfilename, bool longnot) {
   std::string fullh = gethistory(true, longnot);
@@ -297,32 +396,39 @@ void ChessSaving::writefhist(std::string hfilename, bool longnot) {
   hst.close();
 }
 
-//save game in native format, write a file
-void ChessSaving::savegame(const ChessBoard& chb, std::string sfilename) {
-  std::ofstream fbuff;
-  fbuff.open(sfilename, std::ios::out | std::ios::trunc | std::ios::binary);
-  
-  std::string curline;
-  std::stringstream res;
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the native format is written as it is in memory, little endian");
 
-  //write game information not written in the autosave file
-  for (unsigned int i = 0; i < chb.players.size(); i++) {fbuff << chb.players[i]->isplayerhuman() << "|";}
-  fbuff << "*";
-  
-  for (unsigned int i = 0; i < linepos.size(); i++) {//writing position
-    fbuff << linepos[i] << "|";
+//save game in native format, write a binary file (see ChessSaveHeader). Return false if the file cannot be written
+bool ChessSaving::savegame(const ChessBoard& chb, std::string sfilename) {
+  char fen[fensize];
+  ChessSaveHeader hd = makeheader(fen);
+  hd.result = chb.getfinalres();
+  if (std::any_of(clocks.begin(), clocks.end(), [](std::uint32_t c) {return c != noclock;})) {hd.flags |= saveclocks;}
+  if (std::any_of(evals.begin(), evals.end(), [](std::int16_t e) {return e != noeval;})) {hd.flags |= saveevals;}
+  if (chb.players[0] != nullptr && chb.players[1] != nullptr) {
+    hd.flags |= saveplayers;
+    if (chb.players[0]->isplayerhuman()) {hd.flags |= humanwhite;}
+    if (chb.players[1]->isplayerhuman()) {hd.flags |= humanblack;}
   }
-  fbuff << "\n";
-  
-  //copy line by line, in order to save only the lines marked by linepos and automatically discard the line unmarked (e.g. after some back command and repetition of moves)
-  for (unsigned int i = 0; i < linepos.size(); i++) {
-    std::streampos clinep = linepos[i];
-    savebuf.seekg(clinep);
-    std::getline(savebuf, curline);
-    fbuff << curline << "\n";
+
+  std::vector<packedmove> moves(hd.nmoves);
+  std::vector<std::uint32_t> mclocks(hd.nmoves);
+  std::vector<std::int16_t> mevals(hd.nmoves);
+  for (unsigned int i = 0; i < hd.nmoves; i++) {
+    moves[i] = records[i + 1].move;
+    mclocks[i] = getclock(i + 1);
+    mevals[i] = geteval(i + 1);
   }
-  
+
+  std::ofstream fbuff;
+  fbuff.open(sfilename, std::ios::out | std::ios::trunc | std::ios::binary);
+  fbuff.write(reinterpret_cast<const char*>(&hd), sizeof(ChessSaveHeader));
+  fbuff.write(fen, hd.fenlength);
+  fbuff.write(reinterpret_cast<const char*>(moves.data()), moves.size() * sizeof(packedmove));
+  if (hd.flags & saveclocks) {fbuff.write(reinterpret_cast<const char*>(mclocks.data()), mclocks.size() * sizeof(std::uint32_t));}
+  if (hd.flags & saveevals) {fbuff.write(reinterpret_cast<const char*>(mevals.data()), mevals.size() * sizeof(std::int16_t));}
   fbuff.close();
+  return ! fbuff.fail();
 }
 
 //save game in pgn format, write a file
@@ -334,13 +440,13 @@ void ChessSaving::savegamepgn(const ChessBoard& chb, std::string pgnfilename, co
   using std::chrono::system_clock;
   system_clock::time_point curtime = system_clock::now();  
   std::time_t tt = system_clock::to_time_t(curtime);
-  struct tm* timeinfo;
-  timeinfo = localtime(&tt);
-  strftime(tchbuff, 20, "%Y.%m.%d", timeinfo);
+  struct tm timeinfo;
+  localtime_r(&tt, &timeinfo); //the reentrant version, localtime shares a static buffer
+  strftime(tchbuff, 20, "%Y.%m.%d", &timeinfo);
   std::string strtime = tchbuff;
   
   //getting the result
-  int rg;
+  int rg = 0;
   if (chb.getfinalres() == notfinished) {rg = 0;}
   else if (chb.getfinalres() == tie) {rg = 1;}
   else if (chb.getfinalres() == blackwins) {rg = 2;}
@@ -375,97 +481,123 @@ void ChessSaving::savegamepgn(const ChessBoard& chb, std::string pgnfilename, co
   pgnfw.writemoves(devgame, rg);
 }
 
-//load game from file (native format), returns true if the game is successfully loaded.
+//load game from file (native format, or a recovery file), returns true if the game is successfully loaded. The file is mapped in memory.
 bool ChessSaving::loadgame(ChessBoard& chb, std::string lfilename) {
+  int fd = open(lfilename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    std::cerr << "Error, the file " << lfilename << " cannot be opened!" << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size < static_cast<off_t>(sizeof(ChessSaveHeader))) {
+    std::cerr << "Error, the file " << lfilename << " is not a saved game!" << std::endl;
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); //the mapping is kept after closing the file
+  if (data == MAP_FAILED) {return false;}
+
+  bool status = readsaved(chb, static_cast<const char*>(data), st.st_size);
+  munmap(data, st.st_size);
+  return status;
+}
+
+/* read a game in native format from memory. The moves are done on the bitboards only and the journal is filled directly,
+ * the pieces of the chessboard are built once at the end. Returns false if the data are not valid or a move is illegal.
+ */
+bool ChessSaving::readsaved(ChessBoard& chb, const char* data, std::size_t size) {
+  ChessSaveHeader hd;
+  std::memcpy(&hd, data, sizeof(ChessSaveHeader));
+  if (hd.magic != ChessSaveHeader().magic || hd.version > ChessSaveHeader().version) {
+    std::cerr << "Error, the file is not a saved game or it was saved by a newer version!" << std::endl;
+    return false;
+  }
+  std::size_t movesize = sizeof(packedmove) + ((hd.flags & saveclocks) ? sizeof(std::uint32_t) : 0) + ((hd.flags & saveevals) ? sizeof(std::int16_t) : 0);
+  if (size < sizeof(ChessSaveHeader) + hd.fenlength + hd.nmoves * movesize) {
+    std::cerr << "Error, the saved game is truncated!" << std::endl;
+    return false;
+  }
+
+  const char* cur = data + sizeof(ChessSaveHeader);
+  std::string_view fen = (hd.fenlength > 0) ? std::string_view(cur, hd.fenlength) : startfen;
+  cur += hd.fenlength;
+  ChessBitboard pos;
+  if (! pos.readfen(fen)) {return false;}
+  chb.rebuildposition(pos);
+  inifen = (hd.fenlength > 0) ? std::string(fen) : "";
+  autosavegame(chb, true);
+
+  //the fast path: the moves are checked and done on the bitboards, each one is added to the journal
   bool status = true;
-  std::array<bool, 2> humplayers; 
-  std::ifstream sbuff;
-  
-  try {
-    sbuff.open(lfilename, std::ios::in | std::ios::binary);
-    std::string cl, cp;
-    
-    //loading the first line
-    std::getline(sbuff, cl);
-    std::stringstream clbuf(cl);
-    
-    //setting if each player is human or not 
-    for (unsigned int i = 0; i < humplayers.size(); i++) {
-      std::getline(clbuf, cp, '|');
-      if (cp == "0") {humplayers[i] = false;}
-      else {humplayers[i] = true;}
+  char shortnot[notationsize], longnot[notationsize];
+  for (unsigned int i = 0; i < hd.nmoves; i++) {
+    packedmove m;
+    std::memcpy(&m, cur + i * sizeof(packedmove), sizeof(packedmove));
+    if (! pos.islegal(m)) {
+      std::cerr << "Error, illegal move " << i + 1 << " in the saved game!" << std::endl;
+      status = false;
+      break;
     }
-    
-    std::getline(clbuf, cp, '*'); //getting rid of the * character
-    
-    //setting pointers to each line
-    linepos.clear();
-    while (! clbuf.eof()) {
-      std::getline(clbuf, cp, '|');
-      if (cp != "") {
-        int pp = std::stoi(cp); //pp is an int, but it is used as a std::streampos in the next line: automatic conversion
-        linepos.push_back(pp);
-      }
+    pos.writemove(m, shortnot);
+    pos.writemove(m, longnot, true);
+    ChessUndo undo;
+    pos.make_move(m, undo);
+    addrecord(ChessRecord(m, undo, pos.halfmove), pos, shortnot, longnot);
+  }
+  cur += hd.nmoves * sizeof(packedmove);
+
+  if (status) {
+    if (hd.flags & saveclocks) {
+      clocks.resize(hd.nmoves + 1, noclock);
+      std::memcpy(clocks.data() + 1, cur, hd.nmoves * sizeof(std::uint32_t));
+      cur += hd.nmoves * sizeof(std::uint32_t);
     }
-    
-    //set lineiter to the last linepos
-    lineiter = linepos.end();
-    lineiter--;
-    
-    //close and reopen file to erase the content (content is erased by the flat ios::trunc)
-    savebuf.close();
-    savebuf.open(filename.str(), std::ios::out | std::ios::in | std::ios::trunc);
-
-    //copy lines in the autosave file
-    while (! sbuff.eof()) {
-      std::getline(sbuff, cl);
-      savebuf << cl << "\n";
+    if (hd.flags & saveevals) {
+      evals.resize(hd.nmoves + 1, noeval);
+      std::memcpy(evals.data() + 1, cur, hd.nmoves * sizeof(std::int16_t));
     }
-    
-    //setting the game to the last linepos
-    loadstatus(chb);
-    
-  } catch (const std::ifstream::failure e) {
-    std::cerr << e.what() << std::endl;
-    status = false;
-  } catch (std::invalid_argument e) {
-    std::cerr << e.what() << std::endl;
-    status = false;
+    if (hd.result <= whitewins) {chb.finalres = static_cast<gamefinal>(hd.result);}
+    if ((hd.flags & saveplayers) && chb.players[0] != nullptr && chb.players[1] != nullptr) {chb.sethumplayers({{(hd.flags & humanwhite) != 0, (hd.flags & humanblack) != 0}});}
   }
-  
+
+  //the chessboard is set at the last position read
+  loadstatus(chb);
+  if (recwriter != nullptr) {writerecovery(1);}
   return status;
 }
 
 //load a game saved with the standard PGN format
 bool ChessSaving::loadgamepgn(ChessBoard& chb, ChessPGN::pgnmoves allmoves) {
-  bool status = true;
-  std::ifstream sbuff;
-  
-  //do the moves
-  c_color pwm;
-  bool validmove;
-  for (unsigned int i = 0; i < allmoves.size(); i++) {    
-    if (i % 2 == 0) {pwm = white;}
-    else if (i % 2 == 1) {pwm = black;}
-    
-    validmove = chb.chessmove(pwm, allmoves[i]);
-    if (validmove) {
-      //correcting turn counter, drawcounter, and player who did the move for a proper autosavegame, it works because ChessSaving is friend of ChessBoard
-      chb.drawffcounter++;
-      autosavegame(chb, false); //this should be done here, after the increment of drawffcounter and before that of turn
-
-      if (pwm == white) {chb.player_moving = chb.players[1];
-        turnlost = false;
-      } else if (pwm == black) {
-        chb.player_moving = chb.players[0];
-        chb.turn++;
-        turnlost = true;
-      }
-      
-    } else {status = false; break;}
+  for (unsigned int i = 0; i < allmoves.size(); i++) {
+    if (! playmove(chb, allmoves[i])) {return false;}
   }
-  
-  return status;
+  return true;
+}
+
+//do a move of the player who moves, given in algebraic or UCI notation, and save it as done in a game
+bool ChessSaving::playmove(ChessBoard& chb, std::string_view txt) {
+  packedmove m = chb.bboard.parsemove(txt);
+  if (m == nullmove) {return false;}
+  return playmove(chb, m);
+}
+
+//do a legal move of the player who moves and save it as done in a game
+bool ChessSaving::playmove(ChessBoard& chb, packedmove m) {
+  c_color pwm = chb.player_moving->wpcolor();
+  if (! chb.chessmove(pwm, m)) {return false;}
+
+  //correcting turn counter, drawcounter, and player who did the move for a proper autosavegame, it works because ChessSaving is friend of ChessBoard
+  chb.drawffcounter++;
+  autosavegame(chb, false); //this should be done here, after the increment of drawffcounter and before that of turn
+
+  if (pwm == white) {
+    chb.player_moving = chb.players[1];
+  } else if (pwm == black) {
+    chb.player_moving = chb.players[0];
+    chb.turn++;
+  }
+  return true;
 }
 
 
@@ -540,25 +672,21 @@ ChessBoard::ChessBoard(std::string fenpos) {
   saver->readinifen(fenpos);
   construct_board();
   construct_pieces(fenpos);
-  temporarysquares = squares;
-  saver->initcs(".chess_saving");
-  algebnotshort.str("---");
-  algebnotlong.str("---");
+  std::snprintf(algebnotshort.data(), notationsize, "---");
+  std::snprintf(algebnotlong.data(), notationsize, "---");
 }
 
 ChessBoard::~ChessBoard() {
   delete saver;
   delete uciwh;
   delete ucibl;
-  for (unsigned int i = 0; i < pieces.size(); i++) {delete pieces[i];}
 }
 
 //gathering the players
 void ChessBoard::gather_players(ChessPlayer* plw, ChessPlayer* plb) {
   players[0] = plw;
   players[1] = plb;
-  if (playerstart == white) {player_moving = players[0];}
-  else if (playerstart == black) {player_moving = players[1];}
+  player_moving = (bboard.side == white) ? players[0] : players[1];
 }
 
 void ChessBoard::set_board_for_players() {
@@ -614,127 +742,65 @@ bool ChessBoard::start_engine(ChessUCI* ucidialog) {
   return res;
 }
 
-//building the pieces
+//building the pieces. If the FEN notation is not valid the chessboard is marked as invalid and the start position is used
 void ChessBoard::construct_pieces(std::string tfenpos) {
-  std::string fenpos;
+  std::string_view fenpos = startfen;
   if (tfenpos.size() > 0) {fenpos = tfenpos;}
-  else {fenpos = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";} //FEN notation of initial position
-
-  //reading FEN 
-  std::istringstream buffenpos(fenpos);
-  std::string fenchb, fenrow, wmstr, castlstr, enpasstr, fenturn, fendrawc;
-  buffenpos >> fenchb; //extracting chessboard representation from FEN notation
-  std::istringstream buffenchb(fenchb);
 
-  //creating pieces 
-  int i = 0;
-  std::vector<ChessRock*> rockvec;
-   
-  while (! buffenchb.eof()) {
-    std::getline(buffenchb, fenrow, '/');
-    int j = 0;
-    for (unsigned int k = 0; k < fenrow.size(); k++) {
-      std::string elem = fenrow.substr(k, 1);
-      
-      if (isdigit(elem[0])) {j += elem[0] - '0';} //correct coordinate in case of number indicating empty squares 
-      else {//building the piece
-        Piece* cpiec;
-        ChessFEN::IdPair ptype = ChessFEN::fenidtable.at(elem);
-        if (ptype.pi == pawn) {
-          ChessPawn* pppawn = new ChessPawn(ptype.col, j, i);
-          cpiec = pppawn;
-        }
-          
-        else if (ptype.pi == rock) {
-          ChessRock* pprock = new ChessRock(ptype.col, j, i);
-          pprock->beenmoved = true; //it is easier to revert it to false when checking the castling possibilities
-          cpiec = pprock;
-          rockvec.push_back(pprock);
-        }
-          
-        else if (ptype.pi == knight) {
-          ChessKnight* ppknight = new ChessKnight(ptype.col, j, i);
-          cpiec = ppknight;
-        }
-          
-        else if (ptype.pi == bishop) {
-          ChessBishop* ppbishop = new ChessBishop(ptype.col, j, i);
-          cpiec = ppbishop;
-        }
-        
-        else if (ptype.pi == queen) {
-          ChessQueen* ppqueen = new ChessQueen(ptype.col, j, i);
-          cpiec = ppqueen;
-        }
-        
-        else if (ptype.pi == king) {
-          ChessKing* ppking = new ChessKing(ptype.col, j, i);
-          cpiec = ppking;
-          
-          //assigning pointers to kings
-          if (ptype.col == black) {blking = ppking;}
-          else if (ptype.col == white) {whking = ppking;}
-        }
-        pieces.push_back(cpiec);
-        squareinpiece(cpiec);
-        j++; //should be incremented only when there is a piece, otherwise is already incremented by the digit in FEN notation by the right quantity
+  //reading FEN directly into the bitboards
+  ChessBitboard pos;
+  if (! pos.readfen(fenpos)) {
+    std::cerr << "Error, \"" << fenpos << "\" is not a valid FEN notation of a position!" << std::endl;
+    validfen = false;
+    saver->readinifen("");
+    pos.readfen(startfen);
+  }
+  rebuildposition(pos);
+}
+
+//get a snapshot of the current position: the bitboards keep the player who moves and the counters, so the hash key always matches them
+ChessBitboard ChessBoard::getposition() const {
+  return bboard;
+}
+
+//import the position of a snapshot: the journal starts again from it, as a game loaded from its FEN notation
+void ChessBoard::setposition(const ChessBitboard& pos) {
+  rebuildposition(pos);
+  char fen[fensize];
+  std::string_view fenpos(fen, pos.writefen(fen));
+  saver->readinifen((fenpos == startfen) ? "" : std::string(fenpos));
+  saver->autosavegame(*this, true);
+}
+
+//set the position of a snapshot: the bitboards are copied and the pieces are built again from them (the history of the game is not changed)
+void ChessBoard::rebuildposition(const ChessBitboard& pos) {
+  bboard = pos;
+  playerstart = bboard.side;
+  drawffcounter = bboard.halfmove;
+  turn = bboard.fullmove;
+  if (players[0] != nullptr && players[1] != nullptr) {player_moving = (playerstart == white) ? players[0] : players[1];}
+
+  //creating pieces from the bitboards, the rocks which cannot do the castling are marked as moved
+  const int cornerrights[4] = {whkingside, whqueenside, blkingside, blqueenside};
+  const int cornersq[4] = {sqindex(CHVector::max_x -1, CHVector::max_y -1), sqindex(CHVector::min_x, CHVector::max_y -1), sqindex(CHVector::max_x -1, CHVector::min_y), sqindex(CHVector::min_x, CHVector::min_y)};
+  pieces.clear();
+  bitboard occ = bboard.occupied();
+  while (occ) {
+    int sq = bbpopfirst(occ);
+    wpiece w = bboard.typeat(sq);
+    c_color c = bboard.colorat(sq);
+    Piece* cpiec = pieces.add(Piece(w, c, sqfile(sq), sqrow(sq), pieces.count(w, c)));
+    if (w == rock) {
+      cpiec->beenmoved = true;
+      for (int r = 0; r < 4; r++) {
+        if (sq == cornersq[r] && (bboard.castling & cornerrights[r])) {cpiec->beenmoved = false;}
       }
     }
-    i++;
   }
 
-  //selecting player who moves
-  buffenpos >> wmstr; //extracting moving player from FEN notation
-  if (wmstr == "w") {playerstart = white;}
-  else if (wmstr == "b") {playerstart = black;}
-  else {
-    std::cerr << "Error, \"" << wmstr << "\" does not mean anything. This should be \"w\" or \"b\" to indicate who has the move. We will give it to white" << std::endl;
-    playerstart = white;
-    }
-    
-  //selecting castling possibilities
-  buffenpos >> castlstr; //extracting castling possibilities from FEN notation
-  for (unsigned int r = 0; r < rockvec.size(); r++) {
-    ChessRock* cro = rockvec[r];
-    if (cro->gety() == blking->gety() || cro->getx() > blking->getx()) {
-      if (castlstr.find(ChessFEN::kb) != std::string::npos) {cro->beenmoved = false;}
-    }
-    if (cro->gety() == blking->gety() || cro->getx() < blking->getx()) {
-      if (castlstr.find(ChessFEN::qb) != std::string::npos) {cro->beenmoved = false;}
-    }
-    if (cro->gety() == whking->gety() || cro->getx() > whking->getx()) {
-      if (castlstr.find(ChessFEN::kw) != std::string::npos) {cro->beenmoved = false;}
-    }
-    if (cro->gety() == whking->gety() || cro->getx() < whking->getx()) {
-      if (castlstr.find(ChessFEN::qw) != std::string::npos) {cro->beenmoved = false;}
-    }
-  }
-  
   //adding en passant move possibility if present
-  buffenpos >> enpasstr; //extracing en passant position
-  if (enpasstr != "-") {
-    Piece* refpi; ChessPawn* refpawn;
-    int epx = ChessCoordinates::xin(enpasstr.substr(0, 1));
-    int epy = ChessCoordinates::yin(enpasstr.substr(1, 1));
-    
-    if (epy == 2) {refpi = getsquare(epx, epy+1)->p;}
-    else if (epy == 5) {refpi = getsquare(epx, epy-1)->p;}
-    else {std::cerr << "Error, en passant not possible in the indicated square!" << std::endl;}
-    refpawn = dynamic_cast<ChessPawn*>(refpi);
-    if (refpawn == nullptr) {std::cerr << "Error, the related pawn is absent!" << std::endl;}
-    else {
-      ChessFakePawn* ppfkpawn = new ChessFakePawn(refpawn->getcolor(), epx, epy, refpawn);
-      Piece* ppfpp = ppfkpawn;
-      pieces.push_back(ppfpp);
-      squareinpiece(ppfpp);
-    }
-  }
-    
-  //adjusting turnation counter and 50 moves rule draw counter
-  buffenpos >> fendrawc; //extracting draw counter from FEN notation
-  buffenpos >> fenturn; //extracting turn from FEN notation
-  drawffcounter = std::stoi(fendrawc);  
-  turn = std::stoi(fenturn);
+  if (bboard.epsquare != -1) {pieces.add(Piece(fakepawn, !playerstart, sqfile(bboard.epsquare), sqrow(bboard.epsquare)));}
+  linkpieces();
 }
 
 //building the chessboard (replacing ChessSquares in the matrix with the proper constructor)
@@ -749,24 +815,41 @@ void ChessBoard::construct_board() {
   }
 }
 
+//get the attack map of a color, filling it again only if the position changed since the last request
+const ChessAttackMap& ChessBoard::attackmap(c_color c) const {
+  ChessAttackMap& am = attmaps[c];
+  if ((! am.ready) || am.key != bboard.hashkey()) {bboard.fillattackmap(c, am);}
+  return am;
+}
+
 //get a pointer to a ChessSquare from the chessboard
 ChessSquare* ChessBoard::getsquare(int a, int b) {
   ChessSquare* res;
 
-  if (a >= CHVector::min_x && a < CHVector::max_x && b >= CHVector::min_y && b < CHVector::max_y) {res = &squares[a][b];}
+  if (CHVector::isonboard(a, b)) {res = &squares[a][b];}
   else {res = nullptr;}
 
   return res;
 }
 
-//get a pointer to a ChessSquare from the temporary chessboard
-ChessSquare* ChessBoard::getsquaretemp(int a, int b) {
-  ChessSquare* res;
-
-  if (a >= CHVector::min_x && a < CHVector::max_x && b >= CHVector::min_y && b < CHVector::max_y) {res = &temporarysquares[a][b];}
-  else {res = nullptr;}
-
-  return res;
+/* point the squares to the pieces of the list on the chessboard and find the kings,
+ * to be done after the list is filled or its pieces are shifted
+ */
+void ChessBoard::linkpieces() {
+  for (int i = CHVector::min_x; i < CHVector::max_x; i++) {
+    for (int j = CHVector::min_y; j < CHVector::max_y; j++) {emptysquare(i, j);}
+  }
+  
+  whking = nullptr;
+  blking = nullptr;
+  for (unsigned int k = 0; k < pieces.size(); k++) {
+    Piece* pp = pieces[k];
+    squareinpiece(pp);
+    if (pp->getidtype() == king) {
+      if (pp->getcolor() == black) {blking = pp;}
+      else if (pp->getcolor() == white) {whking = pp;}
+    }
+  }
 }
 
 //put the piece in the square corresponding to the internal coordinates of the piece
@@ -797,69 +880,16 @@ void ChessBoard::sethumplayers(std::array<bool, 2> harr) {
   }
 }
 
+//get if players are human or not
+std::array<bool, 2> ChessBoard::gethumplayers() const {
+  return {{players[0]->isplayerhuman(), players[1]->isplayerhuman()}};
+}
+
 //generate FEN representation of the chessboard
 std::string ChessBoard::genFEN() {
-  std::ostringstream res, epstr, castlstr;
-  Piece* ps;
-  ChessRock* rockcastl;
-
-  //writing pieces on the chessboard
-  for (int i = 0; i < CHVector::max_y; i++) {
-    int c = 0;
-    for (int j = 0; j < CHVector::max_x; j++) {
-      ps = getsquare(j, i)->p;
-      
-      if (ps == nullptr) {c++;}
-      else {
-        ChessFEN::IdPair piecetype = ChessFEN::IdPair(ps->getidtype(), ps->getcolor());
-        std::string symb = ChessFEN::getkeyofval(piecetype);
-        if (symb == "") {
-          if (ps->getidtype() == fakepawn) {
-            epstr << ChessCoordinates::xout(j) << ChessCoordinates::yout(i); //saving en passant reference
-            c++;
-          } else {std::cerr << "Error, something wrong when constructing FEN notation" << std::endl;}
-        } else {
-          if (c > 0) {res << c; c = 0;}
-          res << symb;
-        }
-      }
-    }
-    if (c > 0) {res << c; c = 0;}
-    if (i != CHVector::max_y -1) {res << "/";}
-  }
-  res << " ";
-  
-  //adding player who moves
-  if (player_moving->wpcolor() == white) {res << "w" << " ";}
-  else if (player_moving->wpcolor() == black) {res << "b" << " ";}
-  
-  //adding castling possibilities
-  if (! whking->beenmoved) {
-    rockcastl = checkcastlingrock(7, 7);
-    if (rockcastl != nullptr) {castlstr << "K";}
-    rockcastl = checkcastlingrock(0, 7);
-    if (rockcastl != nullptr) {castlstr << "Q";}
-  }
-  if (! blking->beenmoved) {
-    rockcastl = checkcastlingrock(7, 0);
-    if (rockcastl != nullptr) {castlstr << "k";}
-    rockcastl = checkcastlingrock(0, 0);
-    if (rockcastl != nullptr) {castlstr << "q";}
-  }
-  if (castlstr.str().size() > 0) {res << castlstr.str() << " ";}
-  else {res << "- ";}
-  
-  //adding en passant eating square reference
-  if (epstr.str().size() > 0) {res << epstr.str() << " ";}
-  else {res << "- ";}
-  
-  //adding halfmove number from last eating / pawn movement
-  res << drawffcounter << " ";
-  
-  //adding turn number
-  res << turn;
-  
-  return res.str();
+  char buf[fensize];
+  getposition().writefen(buf);
+  return std::string(buf);
 }
 
 //move a piece, from-to are inside the ChessPlayer who do the move, wrapper for another chessmove method
@@ -878,174 +908,35 @@ bool ChessBoard::chessmove(c_color cc, int xa, int ya, int xb, int yb) {
   return rr;
 }
 
-//move a piece, the move is described by a string in short algebraic notation (needed also the color of the moving player), it is a wrapper for another chessmove method
-bool ChessBoard::chessmove(c_color cc, std::string strmove) {
-  ChessSquare *sqfr, *sqto;
-  wpiece mpc;
-  wpiece prompiece = generic;
-  std::string coordstring, promstr;
-  bool res;
-  bool iseat = false;
-  int oxc = -1;
-  int oyc = -1;
-  std::size_t apos;
-  
-  //writing the move
-  if (cc == white) {cbbuf << turn << ". " << strmove;}
-  else if (cc == black) {cbbuf << turn << "... " << strmove;}
-  printmess();
-  
-  //verify special notation for castling
-  if (strmove[0] == 'O') {
-    ChessKing* ptok;
-    if (cc == white) {ptok = whking;}
-    else if (cc == black) {ptok = blking;}
-    sqfr = getsquare(ptok->getx(), ptok->gety());
-    
-    if (strmove == "O-O") {sqto = getsquare(ptok->getx() +2, ptok->gety());}
-    else if (strmove == "O-O-O") {sqto = getsquare(ptok->getx() -2, ptok->gety());}
-    
-    res = chessmove(cc, sqfr, sqto);
-    return res;
-  }
-  
-  //finding the type of the moving piece
-  try {
-    mpc = ChessIdentifiers::arrpid.at(strmove.substr(0, 1));
-    coordstring = strmove.substr(1, strmove.size()-1);
-  } catch (const std::out_of_range oor) {//because pawn is not in arrpid
-    mpc = pawn;
-    coordstring = strmove;
-  }
-  
-  //removing special notations of eating piece (x), check (+), checkmate (#) and promotion (= , this is saved in the dedicated string)
-  promstr = "";
-  apos = coordstring.find('x');
-  if (apos != std::string::npos) {iseat = true; coordstring.erase(apos, 1);}
-
-  apos = coordstring.find('+');
-  if (apos != std::string::npos) {coordstring.erase(apos, 1);}
+//move a piece, the move is described by a string in short or long algebraic notation or in UCI notation (needed also the color of the moving player), it is a wrapper for another chessmove method
+//the text is matched against the legal moves, without copies of the string nor messages
+bool ChessBoard::chessmove(c_color cc, std::string_view strmove) {
+  if (bboard.side != cc) {return false;}
+  packedmove m = bboard.parsemove(strmove);
+  if (m == nullmove) {return false;}
+  return chessmove(cc, m);
+}
 
-  apos = coordstring.find('#');
-  if (apos != std::string::npos) {coordstring.erase(apos, 1);}
-    
-  apos = coordstring.find('=');
-  if (apos != std::string::npos) {
-    promstr = coordstring.substr(apos+1, 1);
-    coordstring.erase(apos, 2);
-    prompiece = ChessIdentifiers::arrpid[promstr];
-  }
+//move a piece, the move is a packed move of the bitboards (needed also the color of the moving player), it is a wrapper for another chessmove method
+bool ChessBoard::chessmove(c_color cc, packedmove m) {
+  if (bboard.side != cc || (! bboard.islegal(m))) {return false;}
 
-  //also suffix annotations (! !! ? ?? ?! !?), if present, are removed
-  apos = coordstring.find("!!");
-  if (apos != std::string::npos) {coordstring.erase(apos, 2);}
-  
-  apos = coordstring.find("!?");
-  if (apos != std::string::npos) {coordstring.erase(apos, 2);}
-  
-  apos = coordstring.find("?!");
-  if (apos != std::string::npos) {coordstring.erase(apos, 2);}
-  
-  apos = coordstring.find("??");
-  if (apos != std::string::npos) {coordstring.erase(apos, 2);}
-  
-  apos = coordstring.find('!');
-  if (apos != std::string::npos) {coordstring.erase(apos, 1);}
-  
-  apos = coordstring.find('?');
-  if (apos != std::string::npos) {coordstring.erase(apos, 1);}
-  
-  if (coordstring.size() == 4) {//both x and y of starting position are indicated
-    oxc = ChessCoordinates::xin(coordstring.substr(0, 1));
-    oyc = ChessCoordinates::yin(coordstring.substr(1, 1));
-    coordstring = coordstring.substr(2, 2);
-  }
-  
-  if (coordstring.size() == 3) {//only x or y of starting position is indicated
-    oxc = ChessCoordinates::xin(coordstring.substr(0, 1));
-    oyc = ChessCoordinates::yin(coordstring.substr(0, 1));
-    coordstring = coordstring.substr(1, 2);
-  }
-    
-  //finally getting coordinates of arrival square
-  int xc = ChessCoordinates::xin(coordstring.substr(0, 1));
-  int yc = ChessCoordinates::yin(coordstring.substr(1, 1));
-  if (xc != -1 && yc != -1) {sqto = getsquare(xc, yc);}
-  else {std::cerr << "Error, problem in coordinate conversion of " << coordstring << std::endl; std::exit(EXIT_FAILURE);}
-
-  //retrieving moving piece
-  std::vector<Piece*> movpcs, movpcsspec, validpcs;
-  if (iseat) {movpcs = ismenacedby(cc, sqto, false, 2);}
-  else {
-    movpcs = ismenacedby(cc, sqto, false, 1);
-    movpcsspec = ismenacedby(cc, sqto, false, 3);
-    for (unsigned int i = 0; i < movpcsspec.size(); i++) {
-      if (std::find(movpcs.begin(), movpcs.end(), movpcsspec[i]) == movpcs.end()) {//verify if element in movpcsspec is not already present
-        movpcs.push_back(movpcsspec[i]);
-      }
-    }
-  }
-
-  Piece* pp;
-  temporarysquares = squares;
-  for (unsigned int i = 0; i < movpcs.size(); i++) {
-    pp = movpcs[i];
-    if (pp->getidtype() == mpc) {
-      //excluding pieces that cannot legally move (for example, because they leave their king in check)
-      sqfr = getsquare(pp->getx(), pp->gety());
-      sqfr->p = nullptr; sqto->p = pp;
-      bool ucheck;
-      if (pp->getcolor() == white) {ucheck = isincheck(whking);}
-      else if (pp->getcolor() == black) {ucheck = isincheck(blking);}
-      squares = temporarysquares; //restoring the square after the test
-      if (!ucheck) {validpcs.push_back(pp);}
-    }
-  }
-  
-  if (validpcs.size() == 0) { }
-  else if (validpcs.size() == 1) {sqfr = getsquare(validpcs[0]->getx(), validpcs[0]->gety());}
-  else if (validpcs.size() > 1) {
-    for (unsigned int i = 0; i < validpcs.size(); i++) {
-      if (oxc == -1 && oyc == -1) {std::cerr << "Error in chessmove with algebraic notation: cannot be more than one piece that can legally move in the arrival square without info on coordinates of moving piece!" << std::endl;}
-      if (validpcs[i]->getx() == oxc || validpcs[i]->gety() == oyc) {sqfr = getsquare(validpcs[i]->getx(), validpcs[i]->gety()); break;}
-    }
-  }
-  
-  //std::cout << strmove << " from: " << ChessCoordinates::xout(sqfr->getx()) << ChessCoordinates::yout(sqfr->gety()) << " to: " << ChessCoordinates::xout(sqto->getx()) << ChessCoordinates::yout(sqto->gety()) << std::endl;
-  res = chessmove(cc, sqfr, sqto, prompiece);
-  return res;
+  ChessSquare* sqfr = &squares[sqfile(movefrom(m))][sqrow(movefrom(m))];
+  ChessSquare* sqto = &squares[sqfile(moveto(m))][sqrow(moveto(m))];
+  return chessmove(cc, sqfr, sqto, ispromotion(m) ? promotedpiece(m) : generic);
 }
 
 //move a piece, from-to gives as pointers to ChessSquares objects (do not care from where these pointers came)
 //the method perform also castling and pawn promotion, and check if the king is in check after the move (invalidating the move in this case)
 bool ChessBoard::chessmove(c_color cc, ChessSquare* froms, ChessSquare* tos, wpiece prompiece) {
   Piece* movingpiece = froms->p;
-  bool okmove, movedone, iseating;
-  ChessKing *ptoking, *potherking;
+  bool okmove, movedone;
+  Piece *ptoking = nullptr, *potherking = nullptr;
   std::stringstream storepos;
   
-  iseating = false;
   okmove = check_rule_move(cc, froms, tos);
   
   if (okmove) {
-    save_cbimage();
-    
-    if (movingpiece->getidtype() == pawn) {drawffcounter = -1;} //resetting counter for drawing after a pawn is moved.
-    
-    if (tos->p != nullptr) {
-      iseating = true;
-      tos->p->ongame = false; //select flag: the piece previously in the arrival square is eated
-      drawffcounter = -1; //resetting counter for drawing after an eating (to -1 in order to compensate for the automatic increment)
-      if (tos->p->getidtype() == fakepawn && movingpiece->getidtype() == pawn) {//handling en passant eating
-        ChessFakePawn* fakepeated = dynamic_cast<ChessFakePawn*>(tos->p);
-        enpassanteating(fakepeated);
-      }
-    }
-    writealgnot(movingpiece, tos, iseating); //the algebraic notation
-    
-    tos->pieceinsquare(movingpiece); //moving the piece: setting the pointer in the arrival square to the piece and modifying internal coordinates
-    froms->p = nullptr; //setting the pointer in the starting square to null
-    
     c_color adv = !cc;
     if (cc == white) {
       ptoking = whking;
@@ -1054,98 +945,53 @@ bool ChessBoard::chessmove(c_color cc, ChessSquare* froms, ChessSquare* tos, wpi
       ptoking = blking;
       potherking = whking;
     }
-        
-    bool kic = isincheck(ptoking); //verify if the king of the player who has just done the move is in check
     
-    //check castling condition if requested. If the move was the castling, further checks are needed to validate and concluded it
-    bool okcastling = true;
-    ChessRock* rockcastling;
+    //the move is valid if it is among the legal moves: the king is not in check at the end of the move (nor during the castling)
+    int fromsq = sqindex(froms->getx(), froms->gety());
+    int tosq = sqindex(tos->getx(), tos->gety());
+    packedmove pmove = bboard.buildmove(fromsq, tosq);
+    bool aftermoveok = (bboard.side == cc) && bboard.islegal(pmove);
     
-    if (reqcastling) {
-      if (ptoking != movingpiece) {
-        std::cerr << "Error! Castling requested whitout moving the King? Something wrong!" << std::endl;
-        std::exit(EXIT_FAILURE);
-      }
+    if (aftermoveok) {
+      movedone = true;
       
-      //checking if king has been moved
-      if (ptoking->beenmoved) {
-        cbbuf << "You already moved the king.\n"; 
-        okcastling = false;
+      //choosing the promoted piece, the promotions are legal all together
+      if (ispromotion(pmove)) {
+        wpiece selpiece;
+        if (prompiece == generic) {selpiece = choose_promotion(cc);}
+        else {selpiece = prompiece;}
+        pmove = bboard.buildmove(fromsq, tosq, selpiece);
       }
       
-      //getting the king position before the move, the square crossed by the king, the squares between the king and the correct rock
-      std::array<ChessSquare*, 2> movingking;
-      std::array<ChessSquare*, 3> sqkingtorock;
-      int ia, ja, jb, jc, jd;
-      unsigned int limktr;
-      
-      ia = froms->getx();
-      ja = froms->gety();
-      
-      if (lastmove.getx() == +2) {jb = +1; jc = 7, jd = 5, limktr = 2;}
-      else if (lastmove.getx() == -2) {jb = -1; jc = 0, jd = 1; limktr = 3;}
-        
-      movingking[0] = &squares[ia][ja];  //starting position of the king
-      movingking[1] = &squares[ia+jb][ja]; //middle square of the moving
-      for (unsigned int l = 0; l < 3; l++) {sqkingtorock[l] = &squares[jd+l][ja];}
-      rockcastling = checkcastlingrock(jc, ja);
-      if (rockcastling == nullptr) {okcastling = false;}
+      if (movingpiece->getidtype() == pawn) {drawffcounter = -1;} //resetting counter for drawing after a pawn is moved.
       
-      //checking if king is in check in the whole move
-      std::vector<Piece*> whomka, whomkb;
-      whomka = ismenacedby(adv, movingking[0], false, 2);
-      whomkb = ismenacedby(adv, movingking[1], false, 2);
-      if ((whomka.size() > 0 || whomkb.size() > 0) || kic) {
-        cbbuf << "The King will be in check during or at the end of the move.\n";
-        okcastling = false;
-      }
-      
-      //checking if squares between the rock and the king are empty
-      for (unsigned int m = 0; m < limktr; m++) {
-        if (sqkingtorock[m]->p != nullptr && sqkingtorock[m]->p != ptoking) {
-          cbbuf << "The squares between the King and the Rock are not all empty.\n";
-          okcastling = false;
-          break;
-        }
+      if (tos->p != nullptr) {
+        tos->p->ongame = false; //select flag: the piece previously in the arrival square is eated
+        drawffcounter = -1; //resetting counter for drawing after an eating (to -1 in order to compensate for the automatic increment)
+        if (tos->p->getidtype() == fakepawn && movingpiece->getidtype() == pawn) {enpassanteating(tos->p);} //handling en passant eating
       }
+      bboard.writemove(pmove, algebnotshort.data()); //the algebraic notation, written before doing the move
+      bboard.writemove(pmove, algebnotlong.data(), true);
       
-      //do the castling
-      if (okcastling) {docastling(rockcastling);} //perform castling (move the rock)
-      else {
-        cbbuf << "Castling not possible!";
-        printmess(true);
-      }
-    }
-    
-    //now checking if the move is valid (some checks are easy to do after the move)
-    bool aftermoveok;
-        
-    if (reqcastling) {aftermoveok = okcastling;} //check if castling condition are satisfied
-    else {aftermoveok = !kic;} //check only if the player's king is in check at the end of the move
-        
-    if (aftermoveok) {
-      movedone = true;
+      tos->pieceinsquare(movingpiece); //moving the piece: setting the pointer in the arrival square to the piece and modifying internal coordinates
+      froms->p = nullptr; //setting the pointer in the starting square to null
       tos->p->beenmoved = true; //set the flag for special move: all special moves are possible only during the first move of the piece.
+      bboard.make_move(pmove, lastundo); //the bitboards are updated all at once, the squares are updated by the following methods
+      lastpmove = pmove;
+      
+      //move the rock in the castling
+      if (movekindof(pmove) == kingcastling) {docastling(checkcastlingrock(CHVector::max_x -1, tos->gety()));}
+      else if (movekindof(pmove) == queencastling) {docastling(checkcastlingrock(CHVector::min_x, tos->gety()));}
       
       //further checks for the pawn
       if (movingpiece->getidtype() == pawn) {
-        ChessPawn* ppawn = dynamic_cast<ChessPawn*> (movingpiece);
-        bool dopromo = ppawn->promoteme(); //check pawn promotion
-        
-        if (dopromo) {
-          wpiece selpiece;
-          if (prompiece == generic) {selpiece = choose_promotion(ppawn->getcolor());}
-          else {selpiece = prompiece;}
-          Piece* ppiece = promotepawn(ppawn, selpiece);
-          algebnotshort << "=" << ppiece->getnalg(); //adding promotion symbol in short algebraic notation
-          algebnotlong << "=" << ppiece->getnalg(); //adding promotion symbol in long algebraic notation
+        if (ispromotion(pmove)) {
+          promotepawn(movingpiece, promotedpiece(pmove));
         }
         
-        if (placefakepawn) {//place the fake pawn for the en passant eating
-          ChessFakePawn* ffpp = new ChessFakePawn(ppawn);
-          ChessSquare* ffppsquare = getsquare(ffpp->getx(), ffpp->gety());
-          ffppsquare->pieceinsquare(ffpp);
-          pieces.push_back(ffpp);
+        if (movekindof(pmove) == doublepush) {//place the fake pawn for the en passant eating
+          int fky = (movingpiece->getcolor() == white) ? movingpiece->gety() +1 : movingpiece->gety() -1;
+          squareinpiece(pieces.add(Piece(fakepawn, movingpiece->getcolor(), movingpiece->getx(), fky)));
         }
       }
       
@@ -1155,8 +1001,6 @@ bool ChessBoard::chessmove(c_color cc, ChessSquare* froms, ChessSquare* tos, wpi
         //assign a winner in the dedicated variable
         if (ptoking->getcolor() == white) {finalres = whitewins;}
         else if (ptoking->getcolor() == black) {finalres = blackwins;}
-        algebnotshort << "#"; //add symbol for checkmate to the move in the short algebraic notation
-        algebnotlong << "#"; //add symbol for checkmate to the move in the long algebraic notation
         
       } else {
         finalres = notfinished;
@@ -1168,25 +1012,47 @@ bool ChessBoard::chessmove(c_color cc, ChessSquare* froms, ChessSquare* tos, wpi
           else if (potherking->getcolor() == black) {cbbuf << "Black";}
           cbbuf << " King is in check!";
           printmess();
-          algebnotshort << "+"; //add symbol for check to the move in the short algebraic notation
-          algebnotlong << "+"; //add symbol for check to the move in the long algebraic notation
         }
       }
       
       //removing fake pawns if present
-      if (ChessFakePawn::getcounter() > 0) {removefakes(movingpiece->getcolor());}
+      removefakes(movingpiece->getcolor());
       
     } else {
-      restore_cbimage();
       movedone = false;
       
-      if (!reqcastling) {
-        ChessSquare* sqwk = getsquare(ptoking->getx(), ptoking->gety());
-        std::vector<Piece*> mm = ismenacedby(adv, sqwk);
+      if (reqcastling) {
+        //finding why the castling is not possible
+        int dir = (tos->getx() > froms->getx()) ? +1 : -1;
+        if (ptoking->beenmoved) {cbbuf << "You already moved the king.\n";}
+        Piece* rockcastling = checkcastlingrock((dir > 0) ? CHVector::max_x -1 : CHVector::min_x, froms->gety());
+        if (attackmap(adv).attacked & (sqbit(fromsq) | sqbit(fromsq + dir) | sqbit(tosq))) {
+          cbbuf << "The King will be in check during or at the end of the move.\n";
+        }
+        if (rockcastling != nullptr) {
+          for (int x = froms->getx() + dir; x != rockcastling->getx(); x += dir) {
+            if (squares[x][froms->gety()].p != nullptr) {
+              cbbuf << "The squares between the King and the Rock are not all empty.\n";
+              break;
+            }
+          }
+        }
+        cbbuf << "Castling not possible!";
+        printmess(true);
+      } else {
+        //the pieces which would menace the king after the move, found by trying the move on the bitboards
+        ChessBitboard trial = bboard;
+        ChessUndo undo;
+        trial.side = cc;
+        trial.make_move(pmove, undo);
+        bitboard menset = trial.attackers(trial.kingsquare(cc), adv);
+        trial.unmake_move(pmove, undo);
         
-        for (unsigned int i = 0; i < mm.size(); i++) { 
-          storepos << mm[i]->getidtxt() << " (" << ChessCoordinates::xout(mm[i]->getx()) << " " << ChessCoordinates::yout(mm[i]->gety()) << ")";
-          if (i != mm.size()-1) {storepos << "\n";}
+        while (menset) {
+          int msq = bbpopfirst(menset);
+          Piece* mp = squares[sqfile(msq)][sqrow(msq)].p;
+          storepos << mp->getidtxt() << " (" << ChessCoordinates::xout(mp->getx()) << " " << ChessCoordinates::yout(mp->gety()) << ")";
+          if (menset) {storepos << "\n";}
         }
         cbbuf << "You cannot do that, your King is or will be in check by " << storepos.str();
         printmess(true);
@@ -1205,15 +1071,15 @@ bool ChessBoard::chessmove(c_color cc, ChessSquare* froms, ChessSquare* tos, wpi
 }
 
 //checking if the rock is available for castling, in input coordinates of the rock, get a valid pointer only if castling condition for the rock are satisfied, othervise is null 
-ChessRock* ChessBoard::checkcastlingrock(int x, int y) {
+Piece* ChessBoard::checkcastlingrock(int x, int y) {
   Piece* pcorner = squares[x][y].p;
-  ChessRock* res = nullptr;
+  Piece* res = nullptr;
   bool writemess = false;
   
   //checking if rock has been moved
   if (pcorner == nullptr) {writemess = true;}
   else {
-    if (pcorner->getidtype() == rock && (! pcorner->beenmoved)) {res = dynamic_cast<ChessRock*>(pcorner);}
+    if (pcorner->getidtype() == rock && (! pcorner->beenmoved)) {res = pcorner;}
     else {writemess = true;}
   }
 
@@ -1244,13 +1110,11 @@ bool ChessBoard::check_rule_move(c_color currc, ChessSquare* fs, ChessSquare* ps
     }
   }
 
-  mp->assign_methods(whatact); //assigning methods of piece for the proper action (move, eating)
-  res = process_move(mp, ps);
+  res = process_move(mp, ps, whatact); //checking the piece for the proper action (move, eating)
 
   //checking for special moves is no move / eating has been performed and special moves are still possible.
   if ((!res) && (!mp->beenmoved)) {
-    mp->assign_methods(3);
-    res = process_move(mp, ps);
+    res = process_move(mp, ps, 3);
     
     if (mp->getidtype() == king) {
       //set if a castling has been requested
@@ -1260,7 +1124,6 @@ bool ChessBoard::check_rule_move(c_color currc, ChessSquare* fs, ChessSquare* ps
       placefakepawn = true;
     }
   }
-  mp->assign_methods(0); //deassigning methods of piece
   
   return res;
 }
@@ -1290,34 +1153,13 @@ bool ChessBoard::check_starting(c_color currc, ChessSquare* stsq) {
   return true;
 }
 
-//verifying that the piece can reach che arrival square
-bool ChessBoard::process_move(Piece* pp, ChessSquare* ts) {
-  CHVector comp;
-  ChessSquare* pcs;
-
-  for (unsigned int i = 0; i < pp->wrdirection(); i++) {
-    for (unsigned int j = 0; j < pp->wrsteps(i); j++) {
-      comp = *pp + pp->getaction(i, j);
-      
-      if (comp.isinvalid()) {break;} // break the inner loop, we are outside the chessboard
-      else {
-        pcs = getsquare(comp.getx(), comp.gety());
-        
-        if (pcs->p == nullptr && *pcs == *ts) {
-          lastmove = pp->getaction(i, j);
-          return true;
-        }
-      
-        if (pcs->p != nullptr) {
-          if (*pcs == *ts) {
-            lastmove = pp->getaction(i, j);
-            return true;
-          }
-          
-          if (pcs->p->getidtype() != fakepawn) {break;} //break inner loop because a piece is on the path of the move
-        }
-      }
-    }
+//verifying that the piece can reach che arrival square, the integer am selects moves, eatings or special moves as in Piece::assign_methods
+bool ChessBoard::process_move(Piece* pp, ChessSquare* ts, int am) {
+  bitboard reached = bboard.actions(pp->getidtype(), pp->getcolor(), sqindex(pp->getx(), pp->gety()), am);
+  
+  if (reached & sqbit(sqindex(ts->getx(), ts->gety()))) {
+    lastmove.setvalues(ts->getx() - pp->getx(), ts->gety() - pp->gety(), false);
+    return true;
   }
   
   return false;
@@ -1325,7 +1167,7 @@ bool ChessBoard::process_move(Piece* pp, ChessSquare* ts) {
 
 //check if the Player is in check, wrapper for another isincheck function
 bool ChessBoard::isincheck(ChessPlayer* cpl) {
-  ChessKing* ck;
+  Piece* ck = nullptr;
   //selecting the king
   if (cpl->wpcolor() == white) {ck = whking;}
   else if (cpl->wpcolor() == black) {ck = blking;}
@@ -1334,19 +1176,14 @@ bool ChessBoard::isincheck(ChessPlayer* cpl) {
   return res;
 }
 
-//check if a ChessKing piece is in check
-bool ChessBoard::isincheck(ChessKing* ck) {
-  bool res = false;
-  c_color kcol = ck->getcolor();
-  ChessSquare* kingpos = getsquare(ck->getx(), ck->gety());
-  std::vector<Piece*> ucheck = ismenacedby(!kcol, kingpos);
-  if (ucheck.size() > 0) {res = true;}
-  return res;
+//check if a king piece is in check
+bool ChessBoard::isincheck(Piece* ck) {
+  return bboard.incheck(ck->getcolor());
 }
 
 //check if it is checkmate for a player, wrapper for the other ischeckmate function
 bool ChessBoard::ischeckmate(ChessPlayer* cpl) {
-  ChessKing* ck;
+  Piece* ck = nullptr;
   c_color kcol;
   
   //selecting the king
@@ -1358,127 +1195,35 @@ bool ChessBoard::ischeckmate(ChessPlayer* cpl) {
   return res;
 }
 
-//check if it is checkmate for a ChessKing piece
-bool ChessBoard::ischeckmate(ChessKing* ck) {
-  c_color kcol, adv;
-    
-  //selecting the king
-  kcol = ck->getcolor();
-  adv = !kcol;
-    
-  //check if the king is at least in check and return false if not (we do not use the dedicated function because we need to keep the vector with the pieces menacing the king)
-  ChessSquare* kingpos = getsquare(ck->getx(), ck->gety());
-  std::vector<Piece*> menk = ismenacedby(adv, kingpos);
-  if (menk.size() == 0) {return false;}
-
-  //check if squares where the king can move are menaced
-  std::vector<ChessSquare*> kingsm = kinglegalmoves(ck);
-  if (kingsm.size() > 0) {return false;}
-  
-  //check if the piece menacing the king can be eated or blocked.
-  bool trajfound = false;
-  CHVector comp;
-  ChessSquare *pcs, *squareck;
-  Piece *menacingk;
-  std::vector<ChessSquare*> trajectory;
-  std::vector<Piece*> menacingset, menacingsetbis;
-
-  if (menk.size() == 1) { //if it is > 1, is checkmate: with a single move, two different pieces cannot be eated or blocked
-    temporarysquares = squares; //copying the chessboard in the temporary chessboard
-    menacingk = menk[0];
-    squareck = getsquare(menacingk->getx(), menacingk->gety());
-    
-    //to check if the piece menacing the king can be eated
-    menacingset = ismenacedby(kcol, squareck);
-    for (unsigned int i = 0; i < menacingset.size(); i++) {
-      if (*(menacingset[i]) == *ck) {
-        menacingsetbis = ismenacedby(adv, squareck);
-        if (menacingsetbis.size() == 0) {return false;}
-      } else {
-        //forcing the eating
-        menacingk->ongame = false;
-        pcs = getsquare(menacingset[i]->getx(), menacingset[i]->gety());
-        squareck->p = menacingset[i]; pcs->p = nullptr;        
-        bool stillcheck = isincheck(ck); //king is not forcefully moved, it is safe to check using this function
-        squares = temporarysquares; //restoring the chessboard
-        menacingk->ongame = true; //replacing the eated piece on the chessboard
-        if (! stillcheck) {return false;}
-      }
-    }
-    
-    //extracting the trajectory: the squares crossed by the menacing piece
-    menacingk->assign_methods(2);
-    for (unsigned int i = 0; i < menacingk->wrdirection(); i++) {
-      trajectory.clear();
-      for (unsigned int j = 0; j < menacingk->wrsteps(i); j++) {
-        comp = *menacingk + menacingk->getaction(i, j);
-        
-        if (comp.isinvalid()) {
-          break;
-        } else {
-          pcs = getsquare(comp.getx(), comp.gety());
-          if (*pcs != *ck) {trajectory.push_back(pcs);}
-          else {
-            trajfound = true;
-            break;
-          }
-        }
-      }
-      if (trajfound) {break;}
-    }
-    menacingk->assign_methods(0);
-    
-    //exploring if the trajectory is menaced by other pieces of the player (if so, the menacing piece can be blocked);
-    //trajectory should be menaced by moves and not eatings
-    for (unsigned int i = 0; i < trajectory.size(); i++) {
-      menacingset.clear();
-      menacingset = ismenacedby(kcol, trajectory[i], true, 1);
-
-      for (unsigned int j = 0; j < menacingset.size(); j++) {
-        if (*(menacingset[j]) != *ck) {
-          //checking if the piece which should be moved can be moved
-          pcs = getsquare(menacingset[j]->getx(), menacingset[j]->gety());
-          trajectory[i]->p = menacingset[j]; pcs->p = nullptr;
-          bool stillcheck = isincheck(ck);
-          squares = temporarysquares; //restoring the chessboard
-          if (! stillcheck) {return false;}
-        }
-      }
-    }
-  }
-
-  //if the method arrives here, nothing can be done: it is checkmate
-  return true;
+//check if it is checkmate for a king piece: only the king of the player who moves can be in check
+bool ChessBoard::ischeckmate(Piece* ck) {
+  if (ck->getcolor() != bboard.side) {return false;}
+  return bboard.ischeckmate();
 }
 
 //check if draw conditions are matched and propose draw
 bool ChessBoard::isdraw(ChessPlayer* plmov) {
-  bool drawdone, drawfifty, drawthree, drawstale, onlykings;
+  bool drawdone = false;
+  bool drawfifty, drawthree, drawstale, deadmaterial;
   
   //rule of 50 moves without eating (just verify the value of the counter)
   if (drawffcounter == 50) {drawfifty = true;}
   else {drawfifty = false;}
   
   //rule of the 3 repeated moves
-  drawthree = saver->drawforthree();
+  drawthree = saver->drawforthree(bboard.halfmove); //the positions before the last pawn move or eating cannot be repeated
   
   //stalemate
   drawstale = isstalemate(plmov);
 
-  //not a rule, but only the kings on the chessboard is also a draw
-  onlykings = true;
-  for (unsigned int i = 0; i < pieces.size(); i++) {
-    if (pieces[i]->getidtype() != king && pieces[i]->ongame == true) {
-      onlykings = false;
-      break;
-    }
-  }
+  //no checkmate is possible with the pieces left (only the kings, a single minor piece, bishops on squares of the same color)
+  deadmaterial = bboard.insufficientmaterial();
   
   if (drawfifty) {drawdone = askdraw(0);}
   else if (drawthree) {drawdone = askdraw(1);}
   else if (drawstale) {drawdone = askdraw(2);}
   
-  if (onlykings) {drawdone = askdraw(3);}
+  if (deadmaterial) {drawdone = askdraw(3);}
 
   if (drawdone) {finalres = tie;} //saving final status of the game for writing
   else if (drawfifty) {drawffcounter = -1;} //reset drawing counter
@@ -1486,186 +1231,67 @@ bool ChessBoard::isdraw(ChessPlayer* plmov) {
   return drawdone;
 }
 
-//check if is stalemate for a player
+//check if is stalemate for a player: only the player who moves can be stalemated
 bool ChessBoard::isstalemate(ChessPlayer* plm) {
-  c_color kcol, adv;
-  
-  //selecting the king
-  ChessKing* pk;
-  kcol = plm->wpcolor();
-  adv = !kcol;
-  if (kcol == white) {pk = whking;}
-  else if (kcol == black) {pk = blking;}
-  
-  //checking if king is in check
-  bool kinc = isincheck(pk);
-  if (kinc) {return false;} //if king is in check, it cannot be stalemate
-  
-  //checking if king has legal moves
-  std::vector<ChessSquare*> kvm = kinglegalmoves(pk);
-  if (kvm.size() > 0) {return false;} //there are legal moves for the king, cannot be stalemate
-  
-  //checking other pieces on the board
-  for (unsigned int i = 0; i < pieces.size(); i++) {
-    Piece* pp = pieces[i];
-    if (pp->getcolor() == kcol && pp->ongame) {
-      if (pp->getidtype() == pawn) {
-        //checking if the pawn can move forward
-        pp->assign_methods(1);
-        std::vector<ChessSquare*> pawmov = exploremoves(pp);
-        pp->assign_methods(0);
-        for (unsigned int j = 0; j < pawmov.size(); j++) {
-          if (pawmov[j]->p == nullptr) {return false;} //at least a pawn can move
-        }
-        
-        //checking if the pawn can eat
-        pp->assign_methods(2);
-        std::vector<ChessSquare*> paweat = exploremoves(pp);
-        pp->assign_methods(0);
-        for (unsigned int j = 0; j < paweat.size(); j++) {
-          if (paweat[j]->p != nullptr) {
-            if (paweat[j]->p->getcolor() == adv) {return false;} //at least a pawn can eat
-          }
-        }
-        
-      } else if (pp->getidtype() != king) {return false;} //we have pieces that are not pawns other than the king
-    }
-  }
-  
-  //if the method arrives here, it is stalemate
-  return true;
+  if (plm->wpcolor() != bboard.side) {return false;}
+  return bboard.isstalemate();
 }
 
-//save an "image" of the chessboard (only the pointers to pieces)
-void ChessBoard::save_cbimage() {
-  for (int i = CHVector::min_x; i < CHVector::max_x; i++) {
-    for (int j = CHVector::min_y; j < CHVector::max_y; j++) {
-      squareimage[i][j] = squares[i][j].p;
-    }
-  }
-  tempdfc = drawffcounter;
-}
-
-//restore the chessboard to the "image"
-void ChessBoard::restore_cbimage() {
-  for (int i = CHVector::min_x; i < CHVector::max_x; i++) {
-    for (int j = CHVector::min_y; j < CHVector::max_y; j++) {
-      squares[i][j].p = squareimage[i][j];
-      if (squares[i][j].p != nullptr) {
-        squares[i][j].pieceinsquare(squares[i][j].p);
-        squares[i][j].p->ongame = true; //replacing piece on the chessboard (the appropriate flag)
-      }
-    }
-  }
-  drawffcounter = tempdfc; //set back the drawing counter
-}
-
-//explore the possible moves
-std::vector<ChessSquare*> ChessBoard::exploremoves(Piece* pp, bool uset) {  
+//explore the possible moves, the integer am selects moves, eatings or special moves as in Piece::assign_methods
+std::vector<ChessSquare*> ChessBoard::exploremoves(Piece* pp, int am) {
   std::vector<ChessSquare*> res;
-  CHVector comp;
-  ChessSquare* pcs;
+  bitboard reached = bboard.actions(pp->getidtype(), pp->getcolor(), sqindex(pp->getx(), pp->gety()), am);
   
-  for (unsigned int i = 0; i < pp->wrdirection(); i++) {
-    for (unsigned int j = 0; j < pp->wrsteps(i); j++) {
-      comp = *pp + pp->getaction(i, j);
-      
-      if (comp.isinvalid()) {
-        break;
-      } else {
-        if (uset) {pcs = getsquaretemp(comp.getx(), comp.gety());}
-        else {pcs = getsquare(comp.getx(), comp.gety());}
-        res.push_back(pcs);
-        if (pcs->p != nullptr) {
-          if (pcs->p->getidtype() != fakepawn) {break;}
-        }
-      }
-    }
+  while (reached) {
+    int sq = bbpopfirst(reached);
+    res.push_back(getsquare(sqfile(sq), sqrow(sq)));
   }
   return res;
 }
 
 //check who a piece is menacing
-std::vector<ChessSquare*> ChessBoard::ismenacing(Piece* tp, int am, bool uset) {
+std::vector<ChessSquare*> ChessBoard::ismenacing(Piece* tp, int am) {
   if (am != 1 && am != 2 && am != 3) {
     std::cerr << "Error! Something wrong with the selection method for moving a piece! The integer is " << am << std::endl;
     std::exit(EXIT_FAILURE);
   }
 
-  tp->assign_methods(am);
-  std::vector<ChessSquare*> menaced = exploremoves(tp, uset);
-  tp->assign_methods(0);
-  return menaced;
+  return exploremoves(tp, am);
 }
 
-//explore all combination of moves, eatings and special moves
-std::vector<ChessSquare*> ChessBoard::exploremoveats(Piece* movp) {
-  std::vector<ChessSquare*> sqtbsgen, sqtbsm, sqtbse, sqtbss;
-  
-  sqtbsm = ismenacing(movp, 1, false);
-  for (unsigned int i = 0; i < sqtbsm.size(); i++) {
-    if (sqtbsm[i]->p == nullptr) {sqtbsgen.push_back(sqtbsm[i]);}
-  }
+//count the move sequences of the given depth starting with the given move, used to divide the perft count among the moves
+std::uint64_t ChessBoard::perft(packedmove m, int depth) const {
+  ChessBitboard work = bboard;
+  ChessUndo undo;
+  work.make_move(m, undo);
+  return work.perft(depth);
+}
 
-  sqtbse = ismenacing(movp, 2, false);
-  for (unsigned int i = 0; i < sqtbse.size(); i++) {
-    if (sqtbse[i]->p != nullptr) {
-      if (sqtbse[i]->p->getcolor() != player_moving->wpcolor()) {sqtbsgen.push_back(sqtbse[i]);}
-    }
-  }
+//explore all the legal moves of a piece: moves, eatings and special moves
+std::vector<ChessSquare*> ChessBoard::exploremoveats(Piece* movp) {
+  std::vector<ChessSquare*> sqtbsgen;
+  MoveList legal;
+  generate_legal(legal);
   
-  if (! movp->beenmoved) {
-    sqtbss = ismenacing(movp, 3, false);
-    for (unsigned int i = 0; i < sqtbss.size(); i++) {
-      if (sqtbss[i]->p == nullptr) {sqtbsgen.push_back(sqtbss[i]);}
-    }
+  int from = sqindex(movp->getx(), movp->gety());
+  for (packedmove m : legal) {
+    //the four promotions share the arrival square, only one is taken
+    if (movefrom(m) == from && ((! ispromotion(m)) || promotedpiece(m) == queen)) {sqtbsgen.push_back(getsquare(sqfile(moveto(m)), sqrow(moveto(m))));}
   }
   
   return sqtbsgen;
 }
 
 //explore king's legal moves (squares not menaced)
-std::vector<ChessSquare*> ChessBoard::kinglegalmoves(ChessKing* pki) {
-  //selecting colors
-  c_color kcol, adv;
-  kcol = pki->getcolor();
-  adv = !kcol;
-    
-  //copying the chessboard in the temporary chessboard
-  temporarysquares = squares;
-  
-  //check if the king is at least menaced and return false if not (we do not use the dedicated function because we need to keep the vector with the pieces menacing the king)
-  ChessSquare* tempkingpos = getsquaretemp(pki->getx(), pki->gety());
-  
-  //check if squares where the king can move are menaced ** from here working on the temporary copy of the chessboard
-  //extracting the squares where the king can move
-  std::vector<ChessSquare*> kingtogo, kingcango, kingsurego;
-  pki->assign_methods(1); //move is used, but is not relevant here if it is a move or an eating, because king moves and eats in the same way
-  kingtogo = exploremoves(pki, true);
-  pki->assign_methods(0);
-  
-  //removing from the squares where the king can move those occupied by other pieces of the same player (cannot be eated)
-  ChessSquare* squareck;
-  for (unsigned int i = 0; i < kingtogo.size(); i++) {
-    squareck = kingtogo[i];
-    if (squareck->p == nullptr) {kingcango.push_back(squareck);}
-    else {
-      if (squareck->p->getcolor() == adv) {kingcango.push_back(squareck);}
-    }
+std::vector<ChessSquare*> ChessBoard::kinglegalmoves(Piece* pki) {
+  //the squares where the king can move without being in check
+  bitboard kingcango = bboard.checkinfo(pki->getcolor()).kingescapes;
+  std::vector<ChessSquare*> kingsurego;
+  while (kingcango) {
+    int tsq = bbpopfirst(kingcango);
+    kingsurego.push_back(getsquare(sqfile(tsq), sqrow(tsq)));
   }
   
-  //check if the valid squares are menaced
-  tempkingpos->p = nullptr; //removing the king from the temporary chessboard
-  std::vector<Piece*> menacingset;
-  for (unsigned int i = 0; i < kingcango.size(); i++) {
-    squareck = kingcango[i];
-    
-    menacingset = ismenacedby(adv, squareck, true, 2);
-    if (menacingset.size() == 0) {kingsurego.push_back(squareck);}
-    menacingset.clear(); 
-  }
-  
-  tempkingpos->p = pki; //putting back the king in the temporary chessboard
   return kingsurego;
 }
 
@@ -1674,7 +1300,7 @@ std::vector<ChessSquare*> ChessBoard::kinglegalmoves(ChessKing* pki) {
  * following the same notation of assing_method of piece
  * no automatic assignment is done for special move, is not needed. To explore for special moves, it should be selected by assigning selmet = 3 
  */
-std::vector<Piece*> ChessBoard::ismenacedby(c_color adv, ChessSquare* tsq, bool usetemp, int selmet) {
+std::vector<Piece*> ChessBoard::ismenacedby(c_color adv, ChessSquare* tsq, int selmet) {
   int imet;
   if (selmet == -1) {
     if (tsq->p != nullptr) {
@@ -1685,25 +1311,20 @@ std::vector<Piece*> ChessBoard::ismenacedby(c_color adv, ChessSquare* tsq, bool
   } else {
     imet = selmet;
   }
-    
-  Piece* evalpiece;
-  std::vector<ChessSquare*> menacedset;
-  std::vector<Piece*> res;
   
-  for (unsigned int i = 0; i < pieces.size(); i++) {
-    evalpiece = pieces[i];
-    if (evalpiece->getcolor() == adv && evalpiece->ongame && evalpiece->getidtype() != fakepawn) {menacedset = ismenacing(evalpiece, imet, usetemp);}
-
-    for (unsigned int j = 0; j < menacedset.size(); j++) {
-      if (*(menacedset[j]) == *tsq) {res.push_back(evalpiece);}
-    }
-    menacedset.clear();
+  //the menacing pieces are found on the attack map, the squares give the corresponding pieces
+  std::vector<Piece*> res;
+  int sq = sqindex(tsq->getx(), tsq->gety());
+  bitboard menset = bboard.menacers(sq, adv, imet, attackmap(adv).attackers[sq]);
+  while (menset) {
+    int msq = bbpopfirst(menset);
+    res.push_back(squares[sqfile(msq)][sqrow(msq)].p);
   }
   return res;
 }
 
 //move the rock in the castling
-void ChessBoard::docastling(ChessRock* rockm) {
+void ChessBoard::docastling(Piece* rockm) {
   ChessSquare* start;
   ChessSquare* arrival;
 
@@ -1725,72 +1346,43 @@ void ChessBoard::docastling(ChessRock* rockm) {
   printmess();
 }
 
-//promote a pawn, substituting it with a new piece
-Piece* ChessBoard::promotepawn(ChessPawn* pp, wpiece wp) {
-  int cx = pp->getx();
-  int cy = pp->gety();
-  ChessSquare* promsquare = getsquare(cx, cy);
-  
-  c_color tcol = pp->getcolor();
-  
-  pp->ongame = false;
-  Piece* newpiece;
-  
-  if (wp == rock) {newpiece = new ChessRock(tcol, cx, cy);}
-  else if (wp == knight) {newpiece = new ChessKnight(tcol, cx, cy);}
-  else if (wp == bishop) {newpiece = new ChessBishop(tcol, cx, cy);}
-  else if (wp == queen) {newpiece = new ChessQueen(tcol, cx, cy);}
-  else {
+//promote a pawn, changing it in place into the new piece
+Piece* ChessBoard::promotepawn(Piece* pp, wpiece wp) {
+  if (pp->getidtype() != pawn || (wp != rock && wp != knight && wp != bishop && wp != queen)) {
     std::cerr << "Error, something wrong with the pawn promotion system!" << std::endl;
     std::exit(EXIT_FAILURE);
   }
   
-  //adding the new piece to the stack of pieces
-  pieces.push_back(newpiece);
-  
-  //place the new piece in the square of the pawn
-  promsquare->pieceinsquare(newpiece);
+  pp->promote(wp, pieces.count(wp, pp->getcolor()));
   
   cbbuf << "Pawn promoted!";
   printmess();
   
-  return newpiece;
+  return pp;
 }
 
 //removing fakepawns of the opposite color
 void ChessBoard::removefakes(c_color cc) {
   c_color rmc = !cc;
-  Piece *atp, *btp;
+  bool removed = false;
   
-  //removing fakepawns from the chessboard (pointer to 0)
-  for (int i = CHVector::min_x; i < CHVector::max_x; i++) {
-    for (int j = CHVector::min_y; j < CHVector::max_y; j++) {
-
-      if (squares[i][j].p != nullptr) {
-        atp = squares[i][j].p;
-        
-        if (atp->getidtype() == fakepawn && atp->getcolor() == rmc) {
-          squares[i][j].p = nullptr;
-        }
-      }
-    }
-  }
-  
-  //removing fakepawns from the vector of pieces and delete them from the computer memory 
+  //removing fakepawns from the list of pieces, the squares are pointed again to the shifted pieces
   for (unsigned int k = 0; k < pieces.size(); k++) {
-    btp = pieces[k];
+    Piece* btp = pieces[k];
     if (btp->getidtype() == fakepawn && btp->getcolor() == rmc) {
-      pieces.erase(pieces.begin() + k);
-      delete btp;
+      pieces.erase(k);
+      removed = true;
+      k--;
     }
   }
+  if (removed) {linkpieces();}
 }
 
-//perform en passant eating (removing eated pawn)
-void ChessBoard::enpassanteating(ChessFakePawn* fkp) {
-  ChessPawn* epeated = fkp->getrefp();
-  epeated->ongame = false;
-  ChessSquare* holdeated = getsquare(epeated->getx(), epeated->gety());
+//perform en passant eating (removing eated pawn, which is behind the fake pawn)
+void ChessBoard::enpassanteating(Piece* fkp) {
+  int py = (fkp->getcolor() == white) ? fkp->gety() -1 : fkp->gety() +1;
+  ChessSquare* holdeated = getsquare(fkp->getx(), py);
+  holdeated->p->ongame = false;
   holdeated->p = nullptr;
 }
 
@@ -1801,8 +1393,8 @@ bool ChessBoard::goback(int n) {
   if (n > 0) {e = n;} else {e = -1 * n;}
   
   for (int i = 0; i < e; i++) {
-    if (saver->lineiter != saver->getbegin()) {
-      saver->lineiter--;
+    if (saver->current > 0) {
+      saver->current--;
     } else {
       res = false;
       break;
@@ -1812,7 +1404,7 @@ bool ChessBoard::goback(int n) {
   std::string mess = saver->loadstatus(*this);
   cbbuf << mess;
   printmess();
-  ChessUCI::forcestopp = true; //if we go back even one move, pondering must be prevented 
+  forcestopp = true; //if we go back even one move, pondering must be prevented 
   return res;
 }
 
@@ -1823,13 +1415,12 @@ bool ChessBoard::goforward(int n) {
   if (n > 0) {e = n;} else {e = -1 * n;}
 
   for (int i = 0; i < e; i++) {
-    saver->lineiter++;
-    if (saver->lineiter == saver->getend()) {
-      saver->lineiter--;
+    if (saver->current + 1 == saver->size()) {
       res = false;
-      ChessUCI::forcestopp = false; //if we come back at the last move after going back
+      forcestopp = false; //if we come back at the last move after going back
       break;
     }
+    saver->current++;
     if (n < 0) {e++;}
   }
   std::string mess = saver->loadstatus(*this);
@@ -1857,57 +1448,6 @@ void ChessBoard::resignmess(void) {
   printmess(true);
 }
 
-//write the algebraic notation of the move and store it in the dedicated attribute
-void ChessBoard::writealgnot(Piece* mvp, ChessSquare* arrsq, bool iseating) {
-  algebnotshort.str("");
-  algebnotlong.str("");
-  algebnotshort << mvp->getnalg(); //add symbol of moving piece only in short notation
-  //algebnotlong << mvp->getnalg();
-    
-  //for short notation, search if a coordinate of the moving piece should be added to avoid ambiguity
-  Piece* altp;
-  std::vector<Piece*> menset;
-  if (iseating) {menset = ismenacedby(mvp->getcolor(), arrsq, false, 2);}
-  else {menset = ismenacedby(mvp->getcolor(), arrsq, false, 1);}
-  
-  temporarysquares = squares;
-  for (unsigned int i = 0; i < menset.size(); i++) {
-    altp = menset[i];
-    if (altp->getcolor() == mvp->getcolor() && altp->getidtype() == mvp->getidtype() && altp->getidtype() != pawn && altp->getnumid() != mvp->getnumid()) {
-      //checking that the alternative piece can legally move (not leaving the king in check)
-      ChessSquare* stasq = getsquare(altp->getx(), altp->gety());
-      stasq->p = nullptr; arrsq->p = altp; //moving the piece
-      bool ucheck;
-      if (altp->getcolor() == white) {ucheck = isincheck(whking);}
-      else if (altp->getcolor() == black) {ucheck = isincheck(blking);}
-      squares = temporarysquares; //restoring the square after the test
-      if (!ucheck) {
-        if (altp->getx() != mvp->getx()) {algebnotshort << ChessCoordinates::xout(mvp->getx());}
-        else if (altp->gety() != mvp->gety()) {algebnotshort << ChessCoordinates::yout(mvp->gety());}
-        break; //needed to consider unrealistic cases where the ambiguity should be resolved between 3 or more pieces, when we found 2, we are satisfied (otherwise, the disambiguity letter is repeated)
-      }
-    }
-  }
-
-  //for long notation, add the coordinate of the moving piece and add -
-  algebnotlong << ChessCoordinates::xout(mvp->getx()) << ChessCoordinates::yout(mvp->gety());
-
-  if (iseating) {
-    if (mvp->getidtype() == pawn) {algebnotshort << ChessCoordinates::xout(mvp->getx());}
-    algebnotshort << "x";
-    algebnotlong << "x";
-  } else {
-    algebnotlong << "-"; //separator between the squares for the long notation (substituted by 'x' if the piece is eating
-  }
-
-  algebnotshort << ChessCoordinates::xout(arrsq->getx()) << ChessCoordinates::yout(arrsq->gety());
-  algebnotlong << ChessCoordinates::xout(arrsq->getx()) << ChessCoordinates::yout(arrsq->gety());
-
-  /* NOTE: symbol for opposite king in check and promoted pawn if needed is not added here but later in the body of chess_move
-   * algebnotshort and algebnotlong strings will be written in the saving file by saver->autosavegame
-   */
-}
-
 //interacting with the chess engine to set here the move (starting and final chessquare of ChessPlayer) according to the response of the engine
 bool ChessBoard::engine_act(ChessPlayer* plm, ChessUCI* ucidialog, bool ponderphase) {
   if (! ponderphase) {
@@ -1916,12 +1456,10 @@ bool ChessBoard::engine_act(ChessPlayer* plm, ChessUCI* ucidialog, bool ponderph
       ucidialog->setfenchb(fenrep);
     }
     if (ucidialog->getpondering() && (! ucidialog->getusefen())) {//if FEN is used in position command, it is impossible to ponder 
-      std::string hh = ucidialog->getprevmoves(); //get formatted history
-      std::stringstream bufhh(hh);
-      std::string mm;
-      while (! bufhh.eof()) {bufhh >> mm;} //take last move done
+      std::string_view hh = ucidialog->getprevmoves(); //get formatted history
+      std::string_view mm = hh.substr(hh.rfind(' ') + 1); //take last move done (the whole string if there is a single move)
              
-      if (ucidialog->getpondermove() == mm && (turn != 1) && (! ChessUCI::forcestopp)) {//excluding the first move, nothing to ponder on the first move and check for a force stop
+      if (ucidialog->getpondermove() == mm && (turn != 1) && (! forcestopp)) {//excluding the first move, nothing to ponder on the first move and check for a force stop
         ucidialog->sendcomm(9);//sending ponderhit
       } else {
         if (turn != 1) {
@@ -1981,7 +1519,7 @@ bool ChessBoard::engine_act(ChessPlayer* plm, ChessUCI* ucidialog, bool ponderph
       ucidialog->sendcomm(6); //sending position
       ucidialog->sendcomm(7); //sending go
     }
-    ChessUCI::forcestopp = false; //resetting to false after each move
+    forcestopp = false; //resetting to false after each move
   }
   
   return true;
@@ -1989,7 +1527,7 @@ bool ChessBoard::engine_act(ChessPlayer* plm, ChessUCI* ucidialog, bool ponderph
 
 //stop the chess engine
 void ChessBoard::engine_stop() {
-  ChessUCI* currce;
+  ChessUCI* currce = nullptr;
   if (player_moving->wpcolor() == white) {currce = uciwh;}
   else if (player_moving->wpcolor() == black) {currce = ucibl;}
   
@@ -2001,3 +1539,21 @@ void ChessBoard::set_cetime(double t) {
   uciwh->set_thinktime(t);
   ucibl->set_thinktime(t);
 }
+
+
+/* ChessBoardBatch methods
+ */
+ChessBoardBatch::ChessBoardBatch(std::string fenpos, bool km) : ChessBoard(fenpos), keepmess(km) {
+  gather_players(&whplayer, &blplayer);
+  set_board_for_players();
+  saver->autosavegame(*this, true);
+}
+
+//the messages are stored only if requested, a line for each message
+void ChessBoardBatch::printmess(bool) {
+  if (keepmess) {
+    messages += cbbuf.str();
+    messages += '\n';
+  }
+  cbbuf.str("");
+}
@@ -26,18 +26,24 @@
 #define CHESSBOARD_H_DEF 1
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <sstream>
 #include <fstream>
+#include <thread>
 
 #include "chess_dconst.hpp"
 #include "chessbase.hpp"
+#include "chessbitboard.hpp"
 #include "chessutils.hpp"
 
 /* Struct to write once filename extensions
  */
 struct ChessExts {
-  static std::string saveext; //extension for files to saving the game
-  static std::string histext; //extension for files to save the history only
+  static const std::string saveext; //extension for files to saving the game
+  static const std::string histext; //extension for files to save the history only
 };
 
 /* Forward declaration to resolve circular dependencies
@@ -45,36 +51,142 @@ struct ChessExts {
  */
 class ChessBoard;
 
-/* Class to manage the the saving system
+/* A ply of the game as kept in the journal of ChessSaving: the packed move and what is needed to undo it, in 8 bytes.
+ * The first record of a journal stands for the initial position and has no move.
+ */
+struct ChessRecord {
+  packedmove move = nullmove;
+  std::uint16_t halfmove = 0; //halfmove counter before the move
+  std::int16_t drawcounter = 0; //counter for the draw of the chessboard after the move
+  std::int8_t epsquare = -1; //en passant square before the move
+  std::uint8_t lost = 0; //castling possibilities before the move in the lowest 4 bits, the eated piece (generic if none) in the highest 4 bits
+
+  ChessRecord() {}
+  ChessRecord(packedmove m, const ChessUndo& undo, int dc) : move(m), halfmove(undo.halfmove), drawcounter(dc), epsquare(undo.epsquare), lost(undo.castling | (undo.eated << 4)) {}
+
+  wpiece eated(void) const {return static_cast<wpiece>(lost >> 4);}
+  ChessUndo undo(std::uint64_t k, materialkey mk) const {return ChessUndo{eated(), lost & 0xF, epsquare, halfmove, k, mk};}
+};
+
+static_assert(sizeof(ChessRecord) == 8, "ChessRecord must stay compact");
+
+/* Header of the files of the native format (little endian). After the header: the FEN notation of the initial position
+ * (fenlength chars, none for the start position), the packed moves (16 bits each), then the clocks of the players
+ * after each move (32 bits each, milliseconds) and the evaluations (16 bits each, centipawns for white), if given by flags.
+ */
+enum savecontent {saveclocks = 1, saveevals = 2, humanwhite = 4, humanblack = 8, saveplayers = 16}; //humanwhite and humanblack are given only with saveplayers
+
+struct ChessSaveHeader {
+  std::array<char, 4> magic = {{'Y', 'G', 'C', 'S'}};
+  std::uint16_t version = 1;
+  std::uint16_t flags = 0; //combination of savecontent bits
+  std::uint32_t nmoves = 0;
+  std::uint16_t fenlength = 0;
+  std::uint8_t result = notfinished; //gamefinal value
+  std::uint8_t reserved = 0;
+};
+
+static_assert(sizeof(ChessSaveHeader) == 16, "ChessSaveHeader is written as it is");
+
+/* Writer of the recovery file (native format without clocks and evaluations) in a background thread.
+ * The changes of the journal are passed through a lock-free queue, with the thread of the chessboard as the only producer;
+ * the writer sleeps while the queue is empty. The moves are written as they arrive, the header counting them is written
+ * only after they are synchronized on disk (fdatasync), at most once per durability window: after a crash, or a power loss,
+ * the file holds the game up to the last synchronization. So the thread of the chessboard never waits for the disk, unless the queue is full.
+ */
+class ChessRecoveryWriter {
+  private:
+    //a change of the file: the move number nmoves is given and the following ones are removed, or a new game is started if fen is given
+    struct Op {
+      std::uint32_t nmoves;
+      packedmove move;
+      std::string* fen; //owned by the writer once in the queue
+    };
+
+    static constexpr unsigned int queuesize = 4096;
+    std::array<Op, queuesize> queue;
+    std::atomic<unsigned int> head{0}; //next op to be read, changed only by the writer
+    std::atomic<unsigned int> tail{0}; //next op to be added, changed only by the producer
+    std::mutex wakemutex; //only to sleep and wake up the writer, the queue does not need it
+    std::condition_variable wakeup;
+    bool running = true; //guarded by wakemutex
+
+    //used only by the writer thread
+    int fd;
+    std::string fname;
+    std::chrono::milliseconds window;
+    std::string fen; //FEN notation of the initial position, empty for the start position
+    std::vector<packedmove> moves;
+    unsigned int dirtyfrom = 0; //first move not written yet
+    unsigned int headmoves = 0; //number of moves counted by the header in the file
+    bool fendirty = false, headdirty = false;
+    std::thread worker;
+
+    void push(const Op&);
+    void work(void);
+    void drain(void);
+    void writemoves(void);
+    void commit(void);
+
+  public:
+    ChessRecoveryWriter(int, std::string, std::chrono::milliseconds);
+    ChessRecoveryWriter(const ChessRecoveryWriter&) = delete;
+    ~ChessRecoveryWriter();
+
+    void startgame(std::string_view);
+    void setmove(unsigned int n, packedmove m) {push(Op{static_cast<std::uint32_t>(n), m, nullptr});} //the move n (from 1) of the game, the file ends with it
+};
+
+/* Class to manage the the saving system.
+ * The game is kept in memory as a journal of records, a file is written only when saving or if the recovery file is set.
+ * A record is 8 bytes, but each move costs about 35 bytes with what is kept beside it: the hash key (8 bytes, for the repetitions
+ * and to undo the move), the move in the three move lists (about 15 bytes, given as they are to the chess engines and the history)
+ * and its share of the keyframes (about 4 bytes). The lengths of the move lists are kept only at the keyframes.
  */
 class ChessSaving {
   friend class ChessUCI; //now ChessUCI can have access to private member of ChessSaving
   
   private:
-    std::stringstream filename;
-    std::fstream savebuf;
-    std::vector<std::streampos> linepos;
-    std::array<std::string, 4> gresults = {{"*", "1/2-1/2", "0-1", "1-0"}};
-    
-    std::string dftsetline(std::string);
+    std::vector<ChessRecord> records; //the journal of the game, the first record is the initial position
+    std::vector<std::uint64_t> reckeys; //hash key of the position after each record
+    std::array<std::string, 3> movelists; //the moves of the records in short, long and UCI notation (indexed by notation), each one followed by a space
+    std::vector<std::uint32_t> clocks; //clock of the player who did the move of each record, noclock if not given (empty if none is given)
+    std::vector<std::int16_t> evals; //evaluation after each record, noeval if not given (empty if none is given)
+    std::vector<ChessBitboard> keyframes; //the position after one record every keyinterval, the first one is the initial position
+    std::vector<std::array<std::uint32_t, 3>> listmarks; //length of the move lists up to the same records of the keyframes
+    ChessBitboard navpos; //the last position reached through the records, with its record
+    unsigned int navrec = 0;
+    static constexpr unsigned int keyinterval = 32;
     std::string inifen;
+    std::string recname; //name of the recovery file, empty if not used
+    ChessRecoveryWriter* recwriter = nullptr;
+
+    ChessBitboard seek(unsigned int);
+    std::size_t listend(unsigned int, int) const;
+    void addrecord(const ChessRecord&, const ChessBitboard&, const char*, const char*);
+    ChessSaveHeader makeheader(char*) const;
+    void writerecovery(unsigned int);
+    bool readsaved(ChessBoard&, const char*, std::size_t);
 
   public:
-    typedef std::vector<std::streampos>::iterator chsaviter;
-    chsaviter lineiter;
+    enum notation {sannot, lannot, ucinot};
+    static constexpr std::uint32_t noclock = 0xFFFFFFFF;
+    static constexpr std::int16_t noeval = -0x8000;
+    unsigned int current = 0; //index of the record of the position on the chessboard
     
     ChessSaving();
     virtual ~ChessSaving();
     
-    bool turnlost = false;
-    
-    chsaviter getbegin(void) {return linepos.begin();}
-    chsaviter getend(void) {return linepos.end();}
+    unsigned int size(void) const {return records.size();}
+    void setclock(std::uint32_t ms) {clocks.resize(records.size(), noclock); clocks[current] = ms;} //clock of the player who did the move of the current record
+    void seteval(std::int16_t cp) {evals.resize(records.size(), noeval); evals[current] = cp;} //evaluation of the current record
+    std::uint32_t getclock(unsigned int i) const {return (i < clocks.size()) ? clocks[i] : noclock;}
+    std::int16_t geteval(unsigned int i) const {return (i < evals.size()) ? evals[i] : noeval;}
     
     void readinifen(std::string ifen) {inifen = ifen;}
-    void initcs(std::string);
+    bool setrecovery(std::string, std::chrono::milliseconds = std::chrono::milliseconds(200));
     
-    bool drawforthree(void);
+    bool drawforthree(int);
         
     void autosavegame(const ChessBoard&, bool);
     std::string loadstatus(ChessBoard&);
@@ -82,12 +194,15 @@ class ChessSaving {
     
     //first bool true to align the algebraic notation, a turn for each line, second bool true to get the long notation, third bool is to get only moves without numeration
     std::string gethistory(bool = true, bool = false, bool = false);
+    std::string_view getmoves(notation) const; //the moves up to the current record, separated by spaces
     
     void writefhist(std::string, bool = false); //bool = true allows long notation 
-    void savegame(const ChessBoard&, std::string);
+    bool savegame(const ChessBoard&, std::string);
     void savegamepgn(const ChessBoard&, std::string, const ChessConfig&);
     bool loadgame(ChessBoard&, std::string);
     bool loadgamepgn(ChessBoard&, ChessPGN::pgnmoves);
+    bool playmove(ChessBoard&, std::string_view);
+    bool playmove(ChessBoard&, packedmove);
 };
 
 /*Class represent a square of the board
@@ -111,7 +226,6 @@ class ChessSquare : public CHVector {
 
 //introducing typedef here: needed inclusion of standard library and ChessSquare class declaration
 typedef std::array<std::array<ChessSquare, 8>, 8> cb_square;
-typedef std::array<std::array<Piece*, 8>, 8> cb_pointers;
 
 /* Abstract class represent a chess player
  */ 
@@ -172,96 +286,121 @@ class ChessBoard {
   protected:
     int turn = 1;
     int drawffcounter = 0;
-    int tempdfc;
+    bool forcestopp = false; //true when a pondering search of the engine must be stopped and a new search started (after going back)
     c_color playerstart = white;
     gamefinal finalres = notfinished; //tells the conclusion of the game
-    std::stringstream algebnotshort;
-    std::stringstream algebnotlong;
+    std::array<char, notationsize> algebnotshort; //notation of the last move, written by ChessBitboard::writemove
+    std::array<char, notationsize> algebnotlong;
+    packedmove lastpmove = nullmove; //the last move done by chessmove, with what is needed to undo it
+    ChessUndo lastundo;
     
     ChessSaving *saver;
-    ChessUCI *uciwh;
-    ChessUCI *ucibl;
+    ChessUCI *uciwh = nullptr;
+    ChessUCI *ucibl = nullptr;
     
-    std::vector<Piece*> pieces;  //piece collection
-    std::array<ChessPlayer*, 2> players; //the players
-    ChessKing *whking, *blking; //pointers to the kings
+    ChessPieceList pieces;  //piece collection, the pieces are stored by value
+    std::array<ChessPlayer*, 2> players = {{nullptr, nullptr}}; //the players
+    Piece *whking = nullptr, *blking = nullptr; //pointers to the kings
     
     /* Main array is x, inner array is y coord. When accessing, outer array is the index in the first square brackets: [x][y]
      */
-    cb_square squares; //the chessboard
-    cb_square temporarysquares; //a temporary chessboard
-    cb_pointers squareimage; //to save an image of the chessboard (only the pointers), used to reset the move if needed
+    cb_square squares; //the chessboard, view of the position linking the squares to the pieces
+    
+    /* The disposition of the pieces as bitboards, it is the reference position for the rules.
+     * It must be updated together with squares whenever a piece is moved, eated or placed.
+     */
+    ChessBitboard bboard;
+    bool validfen = true; //false if the FEN notation given to the constructor is not valid
+    
+    //attack maps of the two colors (indexed by c_color), filled when needed and kept until the position changes
+    mutable std::array<ChessAttackMap, 2> attmaps;
 
     //buffer to store text messages. Printing delegated to virtual function printcb()
     std::stringstream cbbuf;
 
     void construct_pieces(std::string); //to build the pieces, filling the dedicated vector
     void construct_board(void); //building the chessboard
+    void rebuildposition(const ChessBitboard&); //set a position rebuilding the pieces, the history of the game is not changed
+    const ChessAttackMap& attackmap(c_color) const; //the attack map of a color for the current position
 
     void gather_players(ChessPlayer*, ChessPlayer*);
     void set_board_for_players(void);
-    ChessRock* checkcastlingrock(int, int);
+    Piece* checkcastlingrock(int, int);
+    void linkpieces(void); //pointing the squares and the kings to the pieces of the list
 
     bool engine_act(ChessPlayer*, ChessUCI*, bool = false);
     bool check_engine(ChessUCI*, ChessUCI*);
     bool start_engine(ChessUCI*);
 
   public:
-    ChessPlayer* player_moving;
+    ChessPlayer* player_moving = nullptr;
     CHVector lastmove;
     bool reqcastling = false;
     bool placefakepawn = false;
     
     ChessBoard(std::string);
-    ChessBoard(const ChessBoard&);
+    ChessBoard(const ChessBoard&) = delete; //the squares point to the pieces, the saving file is owned: fork the position with getposition / setposition
     virtual ~ChessBoard();
         
     cb_square* getptosquares(void) {return &squares;}
     ChessSquare* getsquare(int a, int b);
-    ChessSquare* getsquaretemp(int a, int b);
     gamefinal getfinalres(void) const {return finalres;}
+    bool isvalid(void) const {return validfen;} //false if the chessboard was built from an invalid FEN notation (the start position is used instead)
+    std::uint64_t hashkey(void) const {return bboard.hashkey();} //Zobrist hash key of the current position
+    materialkey matkey(void) const {return bboard.matkey();} //material key of the current position, the same for all the positions with the same pieces
+    ChessBitboard getposition(void) const; //snapshot of the current position, a small value
+    void setposition(const ChessBitboard&); //set a position, the pieces are rebuilt and a new game starts from it
     std::string wrpgethistory(bool a = true, bool b = true, bool c = true) {return saver->gethistory(a, b, c);} //used to extract information for the analyser
+    std::string_view wrpgetmoves(ChessSaving::notation nt) const {return saver->getmoves(nt);} //the moves up to the current position, as given to the chess engines
     
     void squareinpiece(Piece*);
     void emptysquare(int, int);
     void sethumplayers(std::array<bool, 2>);
+    std::array<bool, 2> gethumplayers(void) const;
     std::string genFEN(void);
     
     bool chessmove(ChessPlayer*); //move given by the ChessPlayer class of the player who move
     bool chessmove(c_color, int, int, int, int); //coordinates determined by integers
-    bool chessmove(c_color, std::string); //read move in algebric notation
+    bool chessmove(c_color, std::string_view); //read move in algebric notation
+    bool chessmove(c_color, packedmove); //a legal move of the bitboards
     bool chessmove(c_color, ChessSquare*, ChessSquare*, wpiece = generic); //move given by starting and arrival ChessSquare pointers
     bool check_starting(c_color, ChessSquare*);
     bool check_rule_move(c_color, ChessSquare*, ChessSquare*);
-    bool process_move(Piece*, ChessSquare*);
+    bool process_move(Piece*, ChessSquare*, int);
     bool isincheck(ChessPlayer*);
-    bool isincheck(ChessKing*);
+    bool isincheck(Piece*);
     bool ischeckmate(ChessPlayer*);
-    bool ischeckmate(ChessKing*);
+    bool ischeckmate(Piece*);
     bool isdraw(ChessPlayer*);
     bool isstalemate(ChessPlayer*);
     
-    void save_cbimage(void);
-    void restore_cbimage(void);
-
-    std::vector<ChessSquare*> exploremoves(Piece*, bool = false); //explore move possibilities
-    std::vector<ChessSquare*> ismenacing(Piece*, int, bool = false); //check if a piece is menacing any opponent's piece
-    std::vector<ChessSquare*> exploremoveats(Piece*); //explore all combination of moves, eatings and special moves
-    std::vector<ChessSquare*> kinglegalmoves(ChessKing*); //explore king's legal moves (squares not menaced)
-    std::vector<Piece*> ismenacedby(c_color, ChessSquare*, bool = false, int = -1); //check if a square (with or without a piece) is menaced by any piece of the given color
+    void generate_legal(MoveList& ml) const {bboard.generate_legal(ml);} //all the legal moves of the player who moves, no allocation is done
+    std::uint64_t perft(int depth) const {ChessBitboard work = bboard; return work.perft(depth);} //number of the move sequences of the given depth
+    std::uint64_t perft(packedmove, int) const; //the same, after doing the given move
+    std::vector<ChessSquare*> exploremoves(Piece*, int); //explore move possibilities
+    std::vector<ChessSquare*> ismenacing(Piece*, int); //check if a piece is menacing any opponent's piece
+    std::vector<ChessSquare*> exploremoveats(Piece*); //explore all the legal moves of a piece: moves, eatings and special moves
+    std::vector<ChessSquare*> kinglegalmoves(Piece*); //explore king's legal moves (squares not menaced)
+    std::vector<Piece*> ismenacedby(c_color, ChessSquare*, int = -1); //check if a square (with or without a piece) is menaced by any piece of the given color
 
-    void docastling(ChessRock*);
-    Piece* promotepawn(ChessPawn*, wpiece);
+    void docastling(Piece*);
+    Piece* promotepawn(Piece*, wpiece);
     void removefakes(c_color);
-    void enpassanteating(ChessFakePawn*);
+    void enpassanteating(Piece*);
 
     bool goback(int = 1);
     bool goforward(int = 1);
     
     bool wrploadgame(ChessPGN::pgnmoves); //public wrapper for the ChessSaving method, needed only for load and not for save
+    bool wrploadgame(std::string fn) {return saver->loadgame(*this, fn);} //public wrapper for the ChessSaving method, a game saved in native format
+    bool wrpsavegame(std::string fn) {return saver->savegame(*this, fn);} //public wrapper for the ChessSaving method, save in native format
+    bool wrpplaymove(std::string_view txt) {return saver->playmove(*this, txt);} //public wrapper for the ChessSaving method, a single move of the player who moves
+    void wrpseteval(std::int16_t cp) {saver->seteval(cp);} //public wrapper for the ChessSaving method, evaluation of the last move done
+    std::int16_t wrpgeteval(unsigned int i) const {return saver->geteval(i);} //public wrapper for the ChessSaving method
+    bool wrpsetrecovery(std::string fn, std::chrono::milliseconds w = std::chrono::milliseconds(200)) {return saver->setrecovery(fn, w);} //public wrapper for the ChessSaving method, the game is written also in a file while playing
+    int writemove(packedmove m, char* buf, bool longnot = false) const {return bboard.writemove(m, buf, longnot);} //notation of a legal move, see ChessBitboard::writemove
     void resignmess(void);
-    
-    void writealgnot(Piece*, ChessSquare*, bool);
+
     
     void engine_stop(void);
     void set_cetime(double);
@@ -277,4 +416,43 @@ class ChessBoard {
     virtual void letgenupdate(void) =0;
 };
 
+/* Player without input, used by the chessboards without GUI: the moves are given directly to the chessboard
+ */
+class ChessPlayerBatch : public ChessPlayer {
+  public:
+    ChessPlayerBatch(c_color c) : ChessPlayer(c, true) {}
+    ~ChessPlayerBatch() {}
+
+    bool player_act(void) override {return false;}
+};
+
+/* Chessboard without input / output, to validate and replay games without the GUI (command line tools, batch jobs).
+ * The messages are discarded unless requested, promotions without the piece are to queen, draws are never accepted.
+ */
+class ChessBoardBatch : public ChessBoard {
+  private:
+    ChessPlayerBatch whplayer{white};
+    ChessPlayerBatch blplayer{black};
+    bool keepmess;
+    std::string messages;
+
+  public:
+    ChessBoardBatch(std::string = "", bool = false);
+    ChessBoardBatch(const ChessBoardBatch&) = delete;
+    ~ChessBoardBatch() {}
+
+    const std::string& getmessages(void) const {return messages;}
+    void clearmessages(void) {messages.clear();}
+
+    //overriding virtual methods, nothing to show and nothing to ask
+    void printmess(bool = false) override;
+    bool turnation(void) override {return false;}
+    void printcb(void) override {}
+    void turnation_end(bool) override {}
+    wpiece choose_promotion(c_color) override {return queen;}
+    bool askdraw(int) override {return false;}
+    std::string printhist(std::string hh, bool = false) override {return hh;}
+    void letgenupdate(void) override {}
+};
+
 #endif
@@ -22,7 +22,7 @@
  */
 
 
-#include <algorithm> //for std::find function
+#include <algorithm> //for std::find and std::clamp functions
 
 #include "chessutils.hpp"
 #include "chessboard.hpp" //should go here and not in chessutils.hpp to avoid some compiler error related to circular dependencies
@@ -89,15 +89,16 @@ ChessPGN::ChessPGN(std::string fn, char fmod) {
           std::string strmov, *search;
           std::istringstream clbuf(allmstr);
 
-          int i = 0;
-          while (! clbuf.eof()) {
-            clbuf >> strmov; //extract a world, using whitespace as separator (default implementation of operator>> )
-            if (i % 3 != 0) {
-              //this is to exclude the last token which is the result of the game, in case it is not located when i % 3 == 0
-              search = std::find(std::begin(gresults), std::end(gresults), strmov);
-              if (search == std::end(gresults)) {movetext.push_back(strmov);}
+          while (clbuf >> strmov) {//extract a world, using whitespace as separator (default implementation of operator>> )
+            //excluding the result of the game and the numeric annotations, removing the move numbers (1. or 1... , also attached to the move)
+            search = std::find(std::begin(gresults), std::end(gresults), strmov);
+            if (search != std::end(gresults) || strmov.front() == '$') {continue;}
+            if (isdigit(strmov.front())) {
+              std::size_t dots = strmov.find_first_not_of("0123456789");
+              if (dots == std::string::npos) {continue;}
+              if (strmov[dots] == '.') {strmov.erase(0, strmov.find_first_not_of('.', dots));} //otherwise it is a castling written with zeros
             }
-            i++;
+            if (strmov.size() > 0) {movetext.push_back(strmov);}
           }
     
           PGNgame* cgame = new PGNgame(tags, movetext);
@@ -197,7 +198,6 @@ std::string ChessPGN::PGNgame::getfield(std::string symbol) {
 std::array<std::string, 11> ChessUCI::guicomms = {{"uci", "debug", "isready", "setoption", "register", "ucinewgame", "position", "go", "stop", "ponderhit", "quit"}};
 std::array<std::string, 8> ChessUCI::engineansw = {{"id", "uciok", "readyok", "bestmove", "copyprotection", "registration", "info", "option"}};
 std::array<std::string, 5> ChessUCI::optiontypes = {{"check", "spin", "combo", "button", "string"}};
-bool ChessUCI::forcestopp = false;
 
 ChessUCI::ChessUCI() : IPCproc() {ptosaver = nullptr;}
 
@@ -220,48 +220,10 @@ void ChessUCI::setcename(std::string fn) {
   filename = std::string(yagdir) + "/.yagchess_ce_" + fn; //yagdir string is passed from makefile
 }
 
-//formatting the moves for a position startpos moves command 
-std::string ChessUCI::getprevmoves() {
-  std::string hist, nhist;
-  
-  if (ptosaver == nullptr) {nhist = fixedhistory;}
-  else {nhist = ptosaver->gethistory(true, true, true);} //getting the long algebraic notation of the moves up to now
-  
-  hist = formatprevmoves(nhist);
-  while (hist.back() == ' ') {hist.erase(hist.size()-1, 1);} //erasing any white space at the end
-
-  return hist;
-}
-
-//formatting the moves for a position startpos moves command 
-std::string ChessUCI::formatprevmoves(std::string hh) {
-  std::stringstream res;
-  std::string strmov;
-  std::size_t apos;
-  std::stringstream bufhist(hh);
-    
-  while (! bufhist.eof()) {
-    strmov.clear();
-    bufhist >> strmov; //extract a move, using whitespace as separator (default implementation of operator>> )
-    apos = strmov.find('-');
-    if (apos != std::string::npos) {strmov.erase(apos, 1);}
-    apos = strmov.find('+');
-    if (apos != std::string::npos) {strmov.erase(apos, 1);}
-    apos = strmov.find('x');
-    if (apos != std::string::npos) {strmov.erase(apos, 1);}
-    apos = strmov.find('#');
-    if (apos != std::string::npos) {strmov.erase(apos, 1);}
-    apos = strmov.find('=');
-    if (apos != std::string::npos) {
-      char promsymbol = tolower(strmov.back()); //tolower is a cctype library function
-      strmov.erase(apos, 2);
-      strmov.append(1, promsymbol);
-    }
-    
-    res << strmov << " ";
-  }
-  
-  return res.str();
+//the moves for a position startpos moves command, no formatting is needed
+std::string_view ChessUCI::getprevmoves() {
+  if (ptosaver == nullptr) {return fixedhistory;}
+  return ptosaver->getmoves(ChessSaving::ucinot); //the UCI notation of the moves up to now, kept by the saver
 }
 
 //prepare a command and send to the engine
@@ -295,7 +257,7 @@ bool ChessUCI::sendcomm(int i) {
       guimess.append(" fen ");
       guimess.append(curfen);
     } else {//using startpos
-      std::string allmoves = getprevmoves();
+      std::string_view allmoves = getprevmoves();
       if (allmoves.size() > 1) {
         guimess.append(" startpos moves ");
         guimess.append(allmoves);
@@ -308,6 +270,7 @@ bool ChessUCI::sendcomm(int i) {
   }
   
   else if (i == 7) {//building go command
+    engscore = noscore; //the score of the new search
     if (gosubc.useme) {
       if (gosubc.limtime > 0) {
         guimess.append(" movetime ");
@@ -387,6 +350,7 @@ bool ChessUCI::geteansw(bool memo) {
         std::getline(buffeline, message);
         if (message[0] == ' ') {message.erase(0, 1);}
         ch_eng_communication(message);
+        readscore(message);
         answok[6] = true;
       }
       
@@ -407,6 +371,20 @@ bool ChessUCI::geteansw(bool memo) {
   return true;
 }
 
+//read the score of an info line, if any: in centipawns, or the number of moves to the mate (negative if the engine is mated)
+void ChessUCI::readscore(std::string info) {
+  std::stringstream infobuf(info);
+  std::string word, unit;
+  int val;
+  while (infobuf >> word) {
+    if (word == "score" && (infobuf >> unit >> val)) {
+      if (unit == "cp") {engscore = std::clamp(val, -matescore, matescore);}
+      else if (unit == "mate") {engscore = (val > 0) ? matescore - val : -matescore - val;}
+      break;
+    }
+  }
+}
+
 //set time left on the clocks
 void ChessUCI::get_lefttimes(double wt, double bt) {
   whtimeleft = wt;
@@ -581,7 +559,7 @@ bool ChessUCI::readcepref() {
       std::getline(clinebuf, opval);
       
       if (optype == optiontypes[0]) {//if check option
-        bool boval;
+        bool boval = false;
         if (opval == "true") {boval = true;}
         else if (opval == "false") {boval = false;}
         for (unsigned int i = 0; i < checkvector.size(); i++) {
@@ -687,8 +665,8 @@ void ChessUCI::applycepref(bool todef) {
 /* Methods of class ChessConfig
  */
 //initializing static members
-std::array<std::string, 9> ChessConfig::confkeys = {{"chess_engines_list", "chess_engine_white", "chess_engine_black", "chess_engine_analyser", 
-  "whoplayers", "white_name", "black_name", "game_time", "ponder"}};
+std::array<std::string, 11> ChessConfig::confkeys = {{"chess_engines_list", "chess_engine_white", "chess_engine_black", "chess_engine_analyser", 
+  "whoplayers", "white_name", "black_name", "game_time", "ponder", "recovery", "recovery_window"}};
 ChessConfig::howplmap ChessConfig::sethowpl = {{"huhu", huhu}, {"huce", huce}, {"cehu", cehu}, {"cece", cece}, {"alte", alte}};
 std::string ChessConfig::nulltxt = "none";
 
@@ -842,13 +820,15 @@ void ChessConfig::writestarthum(c_color lhc) {
 
 //write new config file with default parameters
 void ChessConfig::writedefault() {
-  //set internal variables to default values (which are chosen here): no chess engine in the list, both players human, no time limit
+  //set internal variables to default values (which are chosen here): no chess engine in the list, both players human, no time limit, recovery file written
   chessengines.clear();
   setifhuman(huhu);
   for (unsigned int i = 0; i < chengname.size(); i++) {chengname[i] = nulltxt;}
   for (unsigned int k = 0; k < playernames.size(); k++) {playernames[k] = "";}
   gametime = -1;
   ponder = false;
+  recovery = true;
+  recwindow = 200;
 
   saveconf();
 }
@@ -890,6 +870,8 @@ void ChessConfig::saveconf() {
   std::string strponder;
   if (ponder) {strponder = "true";} else {strponder = "false";}
   outconfigbuf << confkeys[8] << "=" << strponder << std::endl;
+  outconfigbuf << confkeys[9] << "=" << (recovery ? "true" : "false") << std::endl;
+  outconfigbuf << confkeys[10] << "=" << recwindow << std::endl;
   
   outconfigbuf.close();
 }
@@ -948,6 +930,16 @@ bool ChessConfig::readcurrent(std::ifstream &confbuf) {
       else if (argum == "false") {setponder(false);}
     }
     
+    else if (token == confkeys[9]) {
+      if (argum == "true") {setrecovery(true);}
+      else if (argum == "false") {setrecovery(false);}
+    }
+    
+    else if (token == confkeys[10]) {
+      int rw = std::stoi(argum);
+      if (rw > 0) {setrecwindow(rw);}
+    }
+    
     else {res = false;}
   }
   
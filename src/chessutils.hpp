@@ -27,6 +27,7 @@
 
 #include <array>
 #include <vector>
+#include <string_view>
 #include <fstream>
 #include <unordered_map>
 
@@ -119,6 +120,7 @@ class ChessUCI : public IPCproc {
     std::string engponderon;
     std::string optname;
     std::string optvalue;
+    int engscore = noscore; //score of the last info line of the search, in centipawns for the engine
     double thinktime = 0; //in seconds
     double whtimeleft = -1; //in seconds
     double bltimeleft = -1; //in seconds
@@ -178,13 +180,12 @@ class ChessUCI : public IPCproc {
     
     bool pondering = false; //controls pondering
     bool memorizeoption(std::string);
+    void readscore(std::string);
     
   public:
-    /* can be used outside the class as a flag, never checked by methods of this class,
-     * is used to check if a pondering search must be stopped and a new search shoud be started
-     */
-    static bool forcestopp;
-    
+    static constexpr int noscore = -0x8000; //no score given by the engine during the search
+    static constexpr int matescore = 30000; //score of the mate, decreased by the number of moves to the mate
+
     ChessUCI();
     ChessUCI(std::string, std::string);
     virtual ~ChessUCI();
@@ -200,9 +201,9 @@ class ChessUCI : public IPCproc {
     void setfixedhist(std::string hh) {fixedhistory = hh;}
     void setfenchb(std::string ff) {curfen = ff;}
     std::string getpondermove(void) {return engponderon;}
-    std::string getprevmoves(void);
-    std::string formatprevmoves(std::string);
+    std::string_view getprevmoves(void);
     std::string getmovetodo(void) {return engbestmove;}
+    int getscore(void) const {return engscore;} //noscore if the engine did not give one
     bool checkanswok(int i) {return answok[i];}
     void paramoptions(std::string name, std::string value) {optname = name; optvalue = value;} //set internal variables for a setoption command
     void setgosubcomm(CEGoSubcomm sc) {gosubc = sc;} //set internal variables for adding subcommands to a go command
@@ -234,7 +235,7 @@ class ChessConfig {
     typedef std::unordered_map<std::string, howplopt> howplmap;
 
   private:
-    static std::array<std::string, 9> confkeys;
+    static std::array<std::string, 11> confkeys;
     static std::string nulltxt;
     static howplmap sethowpl;
     
@@ -249,6 +250,8 @@ class ChessConfig {
     std::array<std::string, 2> playernames;
     int gametime; //in seconds
     bool ponder;
+    bool recovery = true; //write the recovery file while playing
+    int recwindow = 200; //durability window of the recovery file, in milliseconds
         
   public:  
     ChessConfig();
@@ -263,6 +266,8 @@ class ChessConfig {
     void setplname(unsigned int w, std::string n) {playernames[w] = n;} //set player name
     void setgametime(int t) {gametime = t;} //set time game
     void setponder(bool p) {ponder = p;} //set ponder boolean value
+    void setrecovery(bool r) {recovery = r;} //set if the recovery file is written
+    void setrecwindow(int w) {recwindow = w;} //set the durability window of the recovery file
     std::string getchengname(unsigned int w) const;
     std::string getchengpath(unsigned int) const;
     howplopt getifhuman(void) const {return whoishum;} //get the value of current players option
@@ -271,6 +276,8 @@ class ChessConfig {
     const umapstrstr& getcemap(void) const {return chessengines;} //return the map
     int getgametime(void) const {return gametime;} //get time game
     bool getponder(void) {return ponder;} //get ponder boolean value
+    bool getrecovery(void) const {return recovery;} //get if the recovery file is written
+    int getrecwindow(void) const {return recwindow;} //get the durability window of the recovery file
     c_color getstarthumpl(void) const {return shumpl;} //get the color of the last human player
     
     void writestarthum(c_color);
@@ -507,7 +507,7 @@ void ChessSquareGui::onpopmenacedby(bool seladv) {
   if (seladv) {cex = !cref;}
   else {cex = cref;}
   
-  std::vector<Piece*> pieceset = ownboard->ismenacedby(cex, chs, false, 2);
+  std::vector<Piece*> pieceset = ownboard->ismenacedby(cex, chs, 2);
   std::vector<ChessSquare*> tbs;
   for (unsigned int i = 0; i < pieceset.size(); i++) {tbs.push_back(ownboard->getsquare(pieceset[i]->getx(), pieceset[i]->gety()));}
   
@@ -872,6 +872,14 @@ void ChessWindowGui::on_action_game_new(std::string inifen) {
     blcheng->send_cemessage().connect(sigc::mem_fun(*this, &ChessWindowGui::displaycemess));
     
     pgameboard = new ChessBoardGui(this, whiteplayer, blackplayer, whcheng, blcheng, inifen);
+    if (! pgameboard->isvalid()) {
+      Gtk::MessageDialog mess(*this, "Error");
+      mess.set_secondary_text("\"" + inifen + "\" is not a valid FEN notation of a position.");
+      mess.run();
+
+      on_action_game_close();
+      return;
+    }
 
     if (inifen.size() > 0) {//telling chess engines to use FEN when setting the position
       whcheng->setusefen(true);
@@ -879,6 +887,12 @@ void ChessWindowGui::on_action_game_new(std::string inifen) {
       ucianalys->setusefen(true);
     }
 
+    //if set in the preferences, the game is written in the recovery file by a background thread while playing, the file is left only if yagchess does not end properly
+    if (cnfgf->getrecovery()) {
+      std::string recpath = std::string(yagdir) + "/.yagchess_recovery";
+      if (! pgameboard->wrpsetrecovery(recpath, std::chrono::milliseconds(cnfgf->getrecwindow()))) {std::cerr << "Warning, the recovery file cannot be created." << std::endl;}
+    }
+
     //initializing the timers
     whtimer.init(this, white, cnfgf->getgametime());
     bltimer.init(this, black, cnfgf->getgametime());
@@ -920,6 +934,7 @@ void ChessWindowGui::on_action_game_load() {
 
     std::string initfen = pgnf.readfield(gamepos, "FEN");
     on_action_game_new(initfen); //@@@may be changed, parameters are not those of config file but those of the pgn file
+    if (pgameboard == nullptr) {return;} //the FEN notation of the game is not valid
 
     ChessPGN::pgnmoves cmoves = pgnf.readmoves(gamepos);
     bool loadok = pgameboard->wrploadgame(cmoves);
@@ -1170,9 +1185,7 @@ void ChessWindowGui::on_chess_engine_analyse() {
           std::string fenrep = pgameboard->genFEN();
           ucianalys->setfenchb(fenrep);
         } else {
-          std::string chist = pgameboard->wrpgethistory();
-          std::string cchist = ucianalys->formatprevmoves(chist);
-          ucianalys->setfixedhist(cchist);
+          ucianalys->setfixedhist(std::string(pgameboard->wrpgetmoves(ChessSaving::ucinot)));
         }
         
         ChessAnalysisGui analysdial(this, ucianalys);
@@ -1404,7 +1417,7 @@ bool ChessBoardGui::check_startinggui(c_color cc, ChessSquare* firstsel) {
 void ChessBoardGui::gather_players(ChessPlayerGui* pa, ChessPlayerGui* pb) {
   players[0] = pa;
   players[1] = pb;
-  player_moving = players[0];
+  player_moving = (bboard.side == white) ? players[0] : players[1]; //the game can start with black from a FEN position
 }
 
 //public wrapper to use the saver->savegame method
@@ -1547,12 +1560,15 @@ void ChessBoardGui::turnation_end(bool domove) {
         
         drawffcounter++;
         saver->autosavegame(*this, false); //this should be done here, after the increment of drawffcounter and before that of turn
+        saver->setclock(pwindow->gettimers()[(player_moving->wpcolor() == white) ? 0 : 1] * 1000); //the clock of the player who did the move, saved with the game
+        if (player_moving->ucieng != nullptr && player_moving->ucieng->getscore() != ChessUCI::noscore) {//the evaluation of the engine who did the move, saved for white
+          int score = player_moving->ucieng->getscore();
+          saver->seteval((player_moving->wpcolor() == white) ? score : -score);
+        }
         if (player_moving->wpcolor() == white) {
           player_moving = players[1];
-          saver->turnlost = false;
         } else if (player_moving->wpcolor() == black) {player_moving = players[0];
           turn++;
-          saver->turnlost = true;
         }
       }
 
@@ -1618,7 +1634,7 @@ bool ChessBoardGui::askdraw(int m) {
   if (m == 0) {message << "50 moves have been done without eating or moving a pawn.\n";}
   else if (m == 1) {message << "Threefold repetition: an identical position has occurred at least three times during the course of the game.\n";}
   else if (m == 2) {message << pcolt << " is in Stalemate. Game draw.\n";}
-  else if (m == 3) {message << "Only the kings are on the chessboard. Game draw.\n";}
+  else if (m == 3) {message << "No player has enough pieces left to checkmate. Game draw.\n";}
   else {std::cerr << "Something wrong with valid options for askdraw(). The value " << m << " was received, but 0, 1 or 2 are the only valid options." << std::endl;}
 
   if (m == 0 || m == 1) {
@@ -1900,6 +1916,19 @@ ChessPreferGui::ChessPreferGui(ChessWindowGui* windowparent, ChessConfig* cm) {
   checkb_ponder.signal_toggled().connect(sigc::mem_fun(*this, &ChessPreferGui::on_ponder_checkbutton_toggled));
   setponderasconf();
   
+  //adding checkbox and spinbutton for the recovery file, the window is the maximum time between two synchronizations on disk
+  checkb_recovery.set_label("Write a recovery file");
+  recwinl.set_text("Synchronized every (ms)");
+  recwinsb.set_range(10, 10000);
+  recwinsb.set_increments(10, 100);
+  setrecoveryasconf();
+  checkb_recovery.signal_toggled().connect(sigc::mem_fun(*this, &ChessPreferGui::on_recovery_checkbutton_toggled));
+  recwinsb.signal_value_changed().connect(sigc::mem_fun(*this, &ChessPreferGui::on_recwindow_changed));
+  
+  gridcontainer.attach(checkb_recovery, 0, 7, 1, 1);
+  gridcontainer.attach(recwinl, 1, 7, 1, 1);
+  gridcontainer.attach(recwinsb, 2, 7, 1, 1);
+  
   //adding button to save current impostation
   savecb.set_label("Save current settings");
   savecb.signal_clicked().connect(sigc::mem_fun(*this, &ChessPreferGui::on_save_custom_clicked));
@@ -2065,6 +2094,13 @@ void ChessPreferGui::setponderasconf() {
   checkb_ponder.set_active(pp);
 }
 
+//setting the recovery checkbutton and its window to the values in the config class
+void ChessPreferGui::setrecoveryasconf() {
+  checkb_recovery.set_active(confmanager->getrecovery());
+  recwinsb.set_value(confmanager->getrecwindow());
+  recwinsb.set_sensitive(confmanager->getrecovery());
+}
+
 //signal handler for ceaddb button, adding a chess engine to the list
 void ChessPreferGui::on_add_button_clicked() {
   std::string name, path, txtmess;
@@ -2105,6 +2141,7 @@ void ChessPreferGui::on_set_default_clicked() {
     setcbwhopval();
     setnamesasconf(whname, 0);
     setnamesasconf(blname, 1);
+    setrecoveryasconf();
   }
 }
 
@@ -2259,6 +2296,18 @@ void ChessPreferGui::on_ponder_checkbutton_toggled() {
   confmanager->setponder(vv);
 }
 
+//signal handler for the recovery checkbutton, to switch the recovery file on / off for the next games
+void ChessPreferGui::on_recovery_checkbutton_toggled() {
+  bool vv = checkb_recovery.get_active();
+  confmanager->setrecovery(vv);
+  recwinsb.set_sensitive(vv);
+}
+
+//signal handler for the spinbutton of the durability window of the recovery file
+void ChessPreferGui::on_recwindow_changed() {
+  confmanager->setrecwindow(recwinsb.get_value_as_int());
+}
+
 //signal handler for the entry, allowing to update the player name in the config class
 void ChessPreferGui::on_entry_changed(unsigned int w) {
   Gtk::Entry* pte;
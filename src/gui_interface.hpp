@@ -499,7 +499,7 @@ class ChessPreferGui : public Gtk::Dialog {
     Gtk::Box* mainbox = get_content_area();
     Gtk::Grid gridcontainer;
 
-    Gtk::Label topl, timel, whoplayl, namel_w, namel_b, tlab_a, tlab_b;
+    Gtk::Label topl, timel, whoplayl, namel_w, namel_b, tlab_a, tlab_b, recwinl;
     Gtk::Entry cenamee, cepathe, whname, blname;
     Gtk::Button ceaddb, fipathb, sedefb, savecb;
     Gtk::ScrolledWindow scwinfortable;
@@ -508,7 +508,8 @@ class ChessPreferGui : public Gtk::Dialog {
     Gtk::ComboBox gttablecb, whoplaytablecb;
     Glib::RefPtr<Gtk::ListStore> gttablels;
     Glib::RefPtr<Gtk::ListStore> whoplaytablels;
-    Gtk::CheckButton checkb_ponder;
+    Gtk::CheckButton checkb_ponder, checkb_recovery;
+    Gtk::SpinButton recwinsb;
 
     Gtk::Menu popmenu;
 
@@ -562,6 +563,7 @@ class ChessPreferGui : public Gtk::Dialog {
     bool setcbwhopval(void);
     void setnamesasconf(Gtk::Entry&, unsigned int);
     void setponderasconf(void);
+    void setrecoveryasconf(void);
 
   public:
     ChessPreferGui(ChessWindowGui*, ChessConfig*);
@@ -587,6 +589,10 @@ class ChessPreferGui : public Gtk::Dialog {
     //signal handler for the ponder checkbutton
     void on_ponder_checkbutton_toggled(void);
     
+    //signal handlers for the recovery file checkbutton and its window
+    void on_recovery_checkbutton_toggled(void);
+    void on_recwindow_changed(void);
+    
     //signal handler for the entry holding the player name
     void on_entry_changed(unsigned int);
 };